@@ -0,0 +1,100 @@
+#pragma once
+
+#include "DijkstraRouter.h"
+#include "Graph.h"
+#include "IRouter.h"
+#include "SearchScratch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Per query A* search: Dijkstra ordered by distance + lower bound of the rest of the route.
+  // Vertices are reopened when their distance improves, so the route stays the shortest one
+  // even if the lower bound is admissible but not consistent.
+  template <typename Weight>
+  class AStarRouter : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    // Lower bound of the route weight from vertex to 'to', never greater than the real one
+    using Heuristic = std::function<Weight(VertexId vertex, VertexId to)>;
+
+    AStarRouter(const Graph& graph, Heuristic heuristic);
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                             std::vector<std::optional<Weight>>& table) const override;
+
+  private:
+    static constexpr EdgeId NoEdge = std::numeric_limits<EdgeId>::max();
+
+    const Graph& graph_;
+    Heuristic heuristic_;
+  };
+
+
+  template <typename Weight>
+  AStarRouter<Weight>::AStarRouter(const Graph& graph, Heuristic heuristic)
+      : graph_(graph)
+      , heuristic_(std::move(heuristic))
+  {
+  }
+
+  template <typename Weight>
+  std::optional<Weight> AStarRouter<Weight>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    // Queue keys are estimates, distance + heuristic, the distances stay in the scratch
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(graph_.GetVertexCount());
+    search.Reach(from, Weight{0}, NoEdge, heuristic_(from, to));
+
+    while (!search.queue.empty()) {
+      const auto [estimate, vertex] = search.PopQueue();
+      const Weight distance = search.distances[vertex];
+      if (estimate > distance + heuristic_(vertex, to)) {
+        continue;  // stale item, the vertex was reached by a shorter path since
+      }
+      if (vertex == to) {
+        break;
+      }
+
+      for (const auto arc : graph_.GetOutgoingArcs(vertex)) {
+        assert(arc.weight >= 0);
+        const Weight candidate = distance + arc.weight;
+        if (!search.IsReached(arc.to) || candidate < search.distances[arc.to]) {
+          search.Reach(arc.to, candidate, arc.edge_id, candidate + heuristic_(arc.to, to));
+        }
+      }
+    }
+
+    if (!search.IsReached(to)) {
+      return std::nullopt;
+    }
+    edges.clear();
+    for (EdgeId edge_id = search.parent_edges[to]; edge_id != NoEdge;
+         edge_id = search.parent_edges[graph_.GetEdge(edge_id).from]) {
+      edges.push_back(edge_id);
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+    return search.distances[to];
+  }
+
+  template <typename Weight>
+  void AStarRouter<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                             std::vector<std::optional<Weight>>& table) const {
+    // Many targets can't direct the search, a plain one-to-many search per source is used
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      ComputeOneToManyWeights(graph_, sources[source_idx], targets, table.data() + source_idx * targets.size());
+    }
+  }
+
+}
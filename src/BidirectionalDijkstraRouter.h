@@ -0,0 +1,154 @@
+#pragma once
+
+#include "DijkstraRouter.h"
+#include "Graph.h"
+#include "IRouter.h"
+#include "SearchScratch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace Graph {
+
+  // Per query Dijkstra searches from both ends, stopped once the queues can't improve the
+  // best meeting point. Search state lives in per-thread buffers reused across queries.
+  template <typename Weight>
+  class BidirectionalDijkstraRouter : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                             std::vector<std::optional<Weight>>& table) const override;
+
+  private:
+    static constexpr EdgeId NoEdge = std::numeric_limits<EdgeId>::max();
+
+    const Graph& graph_;
+    // Reversed arcs: incoming edges of vertex v are in_arcs_[in_arc_begins_[v], in_arc_begins_[v + 1]),
+    // their 'to' is the edge tail
+    std::vector<size_t> in_arc_begins_;
+    std::vector<Arc<Weight>> in_arcs_;
+  };
+
+
+  template <typename Weight>
+  BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+      : graph_(graph),
+        in_arc_begins_(graph.GetVertexCount() + 1, 0),
+        in_arcs_(graph.GetEdgeCount())
+  {
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+      ++in_arc_begins_[graph.GetEdge(edge_id).to + 1];
+    }
+    for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+      in_arc_begins_[vertex + 1] += in_arc_begins_[vertex];
+    }
+    std::vector<size_t> next_idxs(in_arc_begins_.begin(), in_arc_begins_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+      const auto& edge = graph.GetEdge(edge_id);
+      in_arcs_[next_idxs[edge.to]++] = {edge.from, edge.weight, edge_id};
+    }
+  }
+
+  template <typename Weight>
+  std::optional<Weight> BidirectionalDijkstraRouter<Weight>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    auto& scratch = SearchScratch<Weight>::Get();
+    SearchSide<Weight>& forward = scratch.forward;
+    SearchSide<Weight>& backward = scratch.backward;
+    forward.StartQuery(graph_.GetVertexCount());
+    backward.StartQuery(graph_.GetVertexCount());
+
+    forward.Reach(from, Weight{0}, NoEdge);
+    backward.Reach(to, Weight{0}, NoEdge);
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    if (from == to) {
+      best_weight = Weight{0};
+    }
+
+    // Settles the closest vertex of the side, relaxing its edges in the side direction
+    auto step = [&](SearchSide<Weight>& side, const SearchSide<Weight>& other_side, bool is_forward) {
+      const auto [distance, vertex] = side.PopQueue();
+      if (distance > side.distances[vertex]) {
+        return;  // stale item
+      }
+
+      // Arc head is the next vertex in the side direction
+      auto relax = [&](const Arc<Weight>& arc) {
+        assert(arc.weight >= 0);
+        const VertexId head = arc.to;
+        const Weight candidate = distance + arc.weight;
+        if (!side.IsReached(head) || candidate < side.distances[head]) {
+          side.Reach(head, candidate, arc.edge_id);
+          if (other_side.IsReached(head)) {
+            const Weight weight = candidate + other_side.distances[head];
+            if (!best_weight || weight < *best_weight) {
+              best_weight = weight;
+              meeting_vertex = head;
+            }
+          }
+        }
+      };
+      if (is_forward) {
+        for (const auto arc : graph_.GetOutgoingArcs(vertex)) {
+          relax(arc);
+        }
+      }
+      else {
+        for (size_t idx = in_arc_begins_[vertex]; idx < in_arc_begins_[vertex + 1]; ++idx) {
+          relax(in_arcs_[idx]);
+        }
+      }
+    };
+
+    while (!forward.queue.empty() && !backward.queue.empty()) {
+      const Weight forward_min = forward.queue.front().first;
+      const Weight backward_min = backward.queue.front().first;
+      if (best_weight && forward_min + backward_min >= *best_weight) {
+        break;
+      }
+      if (forward_min <= backward_min) {
+        step(forward, backward, true);
+      }
+      else {
+        step(backward, forward, false);
+      }
+    }
+
+    if (!best_weight) {
+      return std::nullopt;
+    }
+    edges.clear();
+    for (VertexId vertex = meeting_vertex; forward.parent_edges[vertex] != NoEdge;) {
+      const EdgeId edge_id = forward.parent_edges[vertex];
+      edges.push_back(edge_id);
+      vertex = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+    for (VertexId vertex = meeting_vertex; backward.parent_edges[vertex] != NoEdge;) {
+      const EdgeId edge_id = backward.parent_edges[vertex];
+      edges.push_back(edge_id);
+      vertex = graph_.GetEdge(edge_id).to;
+    }
+    return best_weight;
+  }
+
+  template <typename Weight>
+  void BidirectionalDijkstraRouter<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                                             std::vector<std::optional<Weight>>& table) const {
+    // A single forward search per source covers all targets
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      ComputeOneToManyWeights(graph_, sources[source_idx], targets, table.data() + source_idx * targets.size());
+    }
+  }
+
+}
@@ -0,0 +1,488 @@
+#pragma once
+
+#include "Graph.h"
+#include "IRouter.h"
+#include "SearchScratch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Contraction Hierarchies: vertices are contracted one by one in importance order and
+  // shortcuts keep distances among the remaining ones. A query is a bidirectional search
+  // going up the hierarchy only, found shortcuts are unpacked into graph edges.
+  template <typename Weight>
+  class ContractionHierarchy : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    // Arc ids below graph edge count are graph edges, the rest are shortcuts
+    struct Shortcut {
+      VertexId from;
+      VertexId to;
+      Weight weight;
+      EdgeId first_arc;
+      EdgeId second_arc;
+    };
+
+    struct HierarchyData {
+      std::vector<uint32_t> ranks;  // contraction order of every vertex
+      std::vector<Shortcut> shortcuts;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    // Restores a hierarchy from previously computed ordering and shortcuts
+    ContractionHierarchy(const Graph& graph, HierarchyData data);
+
+    const HierarchyData& GetHierarchyData() const;
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    // Bucket-based batch: one backward upward search per target leaves (target, distance)
+    // in buckets of the vertices it settles, one forward upward search per source scans them
+    void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                             std::vector<std::optional<Weight>>& table) const override;
+
+  private:
+    static constexpr EdgeId NoArc = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight NoRoute = std::numeric_limits<Weight>::max();
+
+    struct Arc {
+      VertexId head;  // the other end of the arc
+      Weight weight;
+      EdgeId id;
+    };
+    using ArcList = std::vector<Arc>;
+
+    class Contractor;
+
+    VertexId GetArcFrom(EdgeId arc_id) const;
+    VertexId GetArcTo(EdgeId arc_id) const;
+    Weight GetArcWeight(EdgeId arc_id) const;
+    void UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const;
+    void BuildSearchGraph();
+    // Calls callback(vertex, distance) for every vertex settled by the search over arcs
+    template <typename Callback>
+    void RunUpwardSearch(VertexId source, const std::vector<ArcList>& arcs, Callback callback) const;
+
+    const Graph& graph_;
+    HierarchyData data_;
+    std::vector<ArcList> upward_arcs_;  // arcs to higher ranked vertices
+    std::vector<ArcList> downward_arcs_;  // reversed arcs coming from higher ranked vertices
+  };
+
+
+  // Preprocessing state: the graph of not yet contracted vertices
+  template <typename Weight>
+  class ContractionHierarchy<Weight>::Contractor {
+  public:
+    Contractor(const Graph& graph, HierarchyData& data)
+        : graph_(graph),
+          data_(data),
+          out_arcs_(graph.GetVertexCount()),
+          in_arcs_(graph.GetVertexCount()),
+          is_contracted_(graph.GetVertexCount(), false),
+          contracted_neighbours_(graph.GetVertexCount(), 0),
+          witness_distances_(graph.GetVertexCount(), NoRoute),
+          is_witness_target_(graph.GetVertexCount(), false)
+    {
+      for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        assert(edge.weight >= 0);
+        if (edge.from != edge.to) {
+          AddArc(edge.from, edge.to, edge.weight, edge_id);
+        }
+      }
+    }
+
+    void Run() {
+      const size_t vertex_count = graph_.GetVertexCount();
+      data_.ranks.assign(vertex_count, 0);
+
+      using QueueItem = std::pair<int64_t, VertexId>;
+      std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+      for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push({ComputePriority(vertex), vertex});
+      }
+
+      uint32_t rank = 0;
+      while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+        // Lazy update: priorities of neighbours change as vertices get contracted
+        const int64_t priority = ComputePriority(vertex);
+        if (!queue.empty() && priority > queue.top().first) {
+          queue.push({priority, vertex});
+          continue;
+        }
+        data_.ranks[vertex] = rank++;
+        Contract(vertex);
+      }
+    }
+
+  private:
+    // Settled vertices limits of one witness search: a rough one while estimating priorities
+    // and a stricter one for contraction itself. Shortcuts are added when the limit is hit.
+    static constexpr size_t EstimationSettleLimit = 10;
+    static constexpr size_t ContractionSettleLimit = 100;
+
+    void AddArc(VertexId from, VertexId to, Weight weight, EdgeId id) {
+      for (auto& arc : out_arcs_[from]) {
+        if (arc.head == to) {
+          if (weight < arc.weight) {
+            arc.weight = weight;
+            arc.id = id;
+            for (auto& in_arc : in_arcs_[to]) {
+              if (in_arc.head == from) {
+                in_arc.weight = weight;
+                in_arc.id = id;
+              }
+            }
+          }
+          return;
+        }
+      }
+      out_arcs_[from].push_back({to, weight, id});
+      in_arcs_[to].push_back({from, weight, id});
+    }
+
+    // Calls callback(from, to, weight, first_arc, second_arc) for every shortcut needed to contract vertex
+    template <typename Callback>
+    void ForEachShortcut(VertexId vertex, size_t settle_limit, Callback callback) {
+      Weight max_out_weight = 0;
+      for (const auto& out_arc : out_arcs_[vertex]) {
+        max_out_weight = std::max(max_out_weight, out_arc.weight);
+        is_witness_target_[out_arc.head] = true;
+      }
+      for (const auto& in_arc : in_arcs_[vertex]) {
+        RunWitnessSearch(in_arc.head, vertex, in_arc.weight + max_out_weight, settle_limit);
+        for (const auto& out_arc : out_arcs_[vertex]) {
+          if (out_arc.head == in_arc.head) {
+            continue;
+          }
+          const Weight shortcut_weight = in_arc.weight + out_arc.weight;
+          if (witness_distances_[out_arc.head] > shortcut_weight) {
+            callback(in_arc.head, out_arc.head, shortcut_weight, in_arc.id, out_arc.id);
+          }
+        }
+        ResetWitnessSearch();
+      }
+      for (const auto& out_arc : out_arcs_[vertex]) {
+        is_witness_target_[out_arc.head] = false;
+      }
+    }
+
+    // Edge difference plus contracted neighbours count
+    int64_t ComputePriority(VertexId vertex) {
+      int64_t shortcut_count = 0;
+      ForEachShortcut(vertex, EstimationSettleLimit, [&shortcut_count](VertexId, VertexId, Weight, EdgeId, EdgeId) {
+        ++shortcut_count;
+      });
+      const int64_t removed_count = in_arcs_[vertex].size() + out_arcs_[vertex].size();
+      return shortcut_count - removed_count + contracted_neighbours_[vertex];
+    }
+
+    void Contract(VertexId vertex) {
+      ForEachShortcut(vertex, ContractionSettleLimit, [this](VertexId from, VertexId to, Weight weight, EdgeId first_arc, EdgeId second_arc) {
+        const EdgeId shortcut_id = graph_.GetEdgeCount() + data_.shortcuts.size();
+        data_.shortcuts.push_back({from, to, weight, first_arc, second_arc});
+        AddArc(from, to, weight, shortcut_id);
+      });
+
+      is_contracted_[vertex] = true;
+      auto is_contracted_head = [this](const Arc& arc) { return is_contracted_[arc.head]; };
+      for (const auto& in_arc : in_arcs_[vertex]) {
+        auto& arcs = out_arcs_[in_arc.head];
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted_head), arcs.end());
+        ++contracted_neighbours_[in_arc.head];
+      }
+      for (const auto& out_arc : out_arcs_[vertex]) {
+        auto& arcs = in_arcs_[out_arc.head];
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted_head), arcs.end());
+        ++contracted_neighbours_[out_arc.head];
+      }
+      ArcList().swap(in_arcs_[vertex]);
+      ArcList().swap(out_arcs_[vertex]);
+    }
+
+    // Bounded Dijkstra from source which doesn't pass through ignored vertex.
+    // Stops as soon as all out neighbours of the ignored vertex are settled.
+    void RunWitnessSearch(VertexId source, VertexId ignored, Weight max_weight, size_t settle_limit) {
+      const size_t target_count = out_arcs_[ignored].size();
+      auto& queue = witness_queue_;
+      witness_distances_[source] = 0;
+      touched_vertices_.push_back(source);
+      queue.push_back({0, source});
+      size_t settled_count = 0;
+      size_t settled_target_count = 0;
+      while (!queue.empty() && settled_count < settle_limit && settled_target_count < target_count) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+        const auto [distance, vertex] = queue.back();
+        queue.pop_back();
+        if (distance > witness_distances_[vertex]) {
+          continue;
+        }
+        if (distance > max_weight) {
+          break;
+        }
+        ++settled_count;
+        settled_target_count += is_witness_target_[vertex];
+        for (const auto& arc : out_arcs_[vertex]) {
+          if (arc.head == ignored) {
+            continue;
+          }
+          const Weight candidate = distance + arc.weight;
+          if (candidate < witness_distances_[arc.head]) {
+            if (witness_distances_[arc.head] == NoRoute) {
+              touched_vertices_.push_back(arc.head);
+            }
+            witness_distances_[arc.head] = candidate;
+            queue.push_back({candidate, arc.head});
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+          }
+        }
+      }
+    }
+
+    void ResetWitnessSearch() {
+      for (const VertexId vertex : touched_vertices_) {
+        witness_distances_[vertex] = NoRoute;
+      }
+      touched_vertices_.clear();
+      witness_queue_.clear();
+    }
+
+    const Graph& graph_;
+    HierarchyData& data_;
+    std::vector<ArcList> out_arcs_;
+    std::vector<ArcList> in_arcs_;
+    std::vector<bool> is_contracted_;
+    std::vector<int64_t> contracted_neighbours_;
+    std::vector<Weight> witness_distances_;
+    std::vector<VertexId> touched_vertices_;
+    std::vector<bool> is_witness_target_;
+    std::vector<std::pair<Weight, VertexId>> witness_queue_;
+  };
+
+
+  template <typename Weight>
+  ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+      : graph_(graph)
+  {
+    Contractor(graph, data_).Run();
+    BuildSearchGraph();
+  }
+
+  template <typename Weight>
+  ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, HierarchyData data)
+      : graph_(graph),
+        data_(std::move(data))
+  {
+    assert(data_.ranks.size() == graph.GetVertexCount());
+    BuildSearchGraph();
+  }
+
+  template <typename Weight>
+  const typename ContractionHierarchy<Weight>::HierarchyData& ContractionHierarchy<Weight>::GetHierarchyData() const {
+    return data_;
+  }
+
+  template <typename Weight>
+  VertexId ContractionHierarchy<Weight>::GetArcFrom(EdgeId arc_id) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    return arc_id < edge_count ? graph_.GetEdge(arc_id).from : data_.shortcuts[arc_id - edge_count].from;
+  }
+
+  template <typename Weight>
+  VertexId ContractionHierarchy<Weight>::GetArcTo(EdgeId arc_id) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    return arc_id < edge_count ? graph_.GetEdge(arc_id).to : data_.shortcuts[arc_id - edge_count].to;
+  }
+
+  template <typename Weight>
+  Weight ContractionHierarchy<Weight>::GetArcWeight(EdgeId arc_id) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    return arc_id < edge_count ? graph_.GetEdge(arc_id).weight : data_.shortcuts[arc_id - edge_count].weight;
+  }
+
+  template <typename Weight>
+  void ContractionHierarchy<Weight>::BuildSearchGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    upward_arcs_.assign(vertex_count, {});
+    downward_arcs_.assign(vertex_count, {});
+
+    // Only the lightest of parallel arcs can be a part of a shortest path
+    auto add_arc = [](ArcList& arcs, Arc new_arc) {
+      for (auto& arc : arcs) {
+        if (arc.head == new_arc.head) {
+          if (new_arc.weight < arc.weight) {
+            arc = new_arc;
+          }
+          return;
+        }
+      }
+      arcs.push_back(new_arc);
+    };
+
+    const size_t arc_count = graph_.GetEdgeCount() + data_.shortcuts.size();
+    for (EdgeId arc_id = 0; arc_id < arc_count; ++arc_id) {
+      const VertexId from = GetArcFrom(arc_id);
+      const VertexId to = GetArcTo(arc_id);
+      if (from == to) {
+        continue;
+      }
+      if (data_.ranks[from] < data_.ranks[to]) {
+        add_arc(upward_arcs_[from], {to, GetArcWeight(arc_id), arc_id});
+      }
+      else {
+        add_arc(downward_arcs_[to], {from, GetArcWeight(arc_id), arc_id});
+      }
+    }
+  }
+
+  template <typename Weight>
+  void ContractionHierarchy<Weight>::UnpackArc(EdgeId arc_id, std::vector<EdgeId>& edges) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    static thread_local std::vector<EdgeId> arcs_stack;
+    arcs_stack.assign(1, arc_id);
+    while (!arcs_stack.empty()) {
+      const EdgeId top_arc_id = arcs_stack.back();
+      arcs_stack.pop_back();
+      if (top_arc_id < edge_count) {
+        edges.push_back(top_arc_id);
+      }
+      else {
+        const auto& shortcut = data_.shortcuts[top_arc_id - edge_count];
+        arcs_stack.push_back(shortcut.second_arc);
+        arcs_stack.push_back(shortcut.first_arc);
+      }
+    }
+  }
+
+  template <typename Weight>
+  std::optional<Weight> ContractionHierarchy<Weight>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    // Index 0 is the forward search from 'from', index 1 is the backward search from 'to'
+    auto& scratch = SearchScratch<Weight>::Get();
+    SearchSide<Weight>* sides[2] = {&scratch.forward, &scratch.backward};
+    const std::vector<ArcList>* search_arcs[2] = {&upward_arcs_, &downward_arcs_};
+    for (SearchSide<Weight>* side : sides) {
+      side->StartQuery(graph_.GetVertexCount());
+    }
+    sides[0]->Reach(from, 0, NoArc);
+    sides[1]->Reach(to, 0, NoArc);
+
+    Weight best_weight = NoRoute;
+    std::optional<VertexId> meeting_vertex;
+    while (true) {
+      const Weight min_forward = sides[0]->queue.empty() ? NoRoute : sides[0]->queue.front().first;
+      const Weight min_backward = sides[1]->queue.empty() ? NoRoute : sides[1]->queue.front().first;
+      if (std::min(min_forward, min_backward) >= best_weight) {
+        break;
+      }
+      const size_t direction = min_forward <= min_backward ? 0 : 1;
+      SearchSide<Weight>& side = *sides[direction];
+      const SearchSide<Weight>& opposite_side = *sides[1 - direction];
+      const auto [distance, vertex] = side.PopQueue();
+      if (distance > side.distances[vertex]) {
+        continue;
+      }
+
+      if (opposite_side.IsReached(vertex) && distance + opposite_side.distances[vertex] < best_weight) {
+        best_weight = distance + opposite_side.distances[vertex];
+        meeting_vertex = vertex;
+      }
+
+      for (const auto& arc : (*search_arcs[direction])[vertex]) {
+        const Weight candidate = distance + arc.weight;
+        if (!side.IsReached(arc.head) || candidate < side.distances[arc.head]) {
+          side.Reach(arc.head, candidate, arc.id);
+        }
+      }
+    }
+
+    if (!meeting_vertex) {
+      return std::nullopt;
+    }
+
+    // Forward arcs are unpacked from the meeting vertex back and reversed
+    edges.clear();
+    for (VertexId vertex = *meeting_vertex; sides[0]->parent_edges[vertex] != NoArc; vertex = GetArcFrom(sides[0]->parent_edges[vertex])) {
+      const size_t begin = edges.size();
+      UnpackArc(sides[0]->parent_edges[vertex], edges);
+      std::reverse(edges.begin() + begin, edges.end());
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (VertexId vertex = *meeting_vertex; sides[1]->parent_edges[vertex] != NoArc; vertex = GetArcTo(sides[1]->parent_edges[vertex])) {
+      UnpackArc(sides[1]->parent_edges[vertex], edges);
+    }
+    return best_weight;
+  }
+
+  template <typename Weight>
+  template <typename Callback>
+  void ContractionHierarchy<Weight>::RunUpwardSearch(VertexId source, const std::vector<ArcList>& arcs, Callback callback) const {
+    // Search spaces going up the hierarchy are small, only touched vertices are kept
+    std::unordered_map<VertexId, Weight> distances = {{source, 0}};
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    queue.push({0, source});
+    while (!queue.empty()) {
+      const auto [distance, vertex] = queue.top();
+      queue.pop();
+      if (distance > distances[vertex]) {
+        continue;
+      }
+      callback(vertex, distance);
+      for (const auto& arc : arcs[vertex]) {
+        const Weight candidate = distance + arc.weight;
+        const auto [it, is_inserted] = distances.emplace(arc.head, candidate);
+        if (is_inserted || candidate < it->second) {
+          it->second = candidate;
+          queue.push({candidate, arc.head});
+        }
+      }
+    }
+  }
+
+  template <typename Weight>
+  void ContractionHierarchy<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                                         std::vector<std::optional<Weight>>& table) const {
+    struct BucketEntry {
+      size_t target_idx;
+      Weight distance;
+    };
+    std::unordered_map<VertexId, std::vector<BucketEntry>> buckets;
+    for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+      RunUpwardSearch(targets[target_idx], downward_arcs_, [&](VertexId vertex, Weight distance) {
+        buckets[vertex].push_back({target_idx, distance});
+      });
+    }
+
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      std::optional<Weight>* row = table.data() + source_idx * targets.size();
+      RunUpwardSearch(sources[source_idx], upward_arcs_, [&](VertexId vertex, Weight distance) {
+        const auto it = buckets.find(vertex);
+        if (it == buckets.end()) {
+          return;
+        }
+        for (const auto& entry : it->second) {
+          const Weight weight = distance + entry.distance;
+          if (!row[entry.target_idx] || weight < *row[entry.target_idx]) {
+            row[entry.target_idx] = weight;
+          }
+        }
+      });
+    }
+  }
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "Graph.h"
+#include "IRouter.h"
+#include "SearchScratch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Per query Dijkstra search with a binary heap: no precomputation, O(V) per-thread search buffers
+  template <typename Weight>
+  class DijkstraRouter : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    DijkstraRouter(const Graph& graph);
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                             std::vector<std::optional<Weight>>& table) const override;
+
+  private:
+    const Graph& graph_;
+  };
+
+
+  // Shortest path over the frozen graph arcs weighted by get_weight(arc) instead of the edge weights,
+  // so a route can be searched with another metric on the same topology. Search state lives
+  // in per-thread buffers reused across queries.
+  template <typename Weight, typename GetWeight>
+  std::optional<Weight> ComputeShortestPath(const DirectedWeightedGraph<Weight>& graph, VertexId from, VertexId to,
+                                            GetWeight get_weight, std::vector<EdgeId>& edges) {
+    constexpr EdgeId NoEdge = std::numeric_limits<EdgeId>::max();
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(graph.GetVertexCount());
+    search.Reach(from, Weight{0}, NoEdge);
+
+    while (!search.queue.empty()) {
+      const auto [distance, vertex] = search.PopQueue();
+      if (distance > search.distances[vertex]) {
+        continue;  // stale item
+      }
+      if (vertex == to) {
+        break;
+      }
+
+      for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+        const Weight weight = get_weight(arc);
+        assert(weight >= 0);
+        const Weight candidate = distance + weight;
+        if (!search.IsReached(arc.to) || candidate < search.distances[arc.to]) {
+          search.Reach(arc.to, candidate, arc.edge_id);
+        }
+      }
+    }
+
+    if (!search.IsReached(to)) {
+      return std::nullopt;
+    }
+    edges.clear();
+    for (EdgeId edge_id = search.parent_edges[to]; edge_id != NoEdge; edge_id = search.parent_edges[graph.GetEdge(edge_id).from]) {
+      edges.push_back(edge_id);
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+    return search.distances[to];
+  }
+
+  // Complete shortest path tree of source: distances and edges vertices were reached by,
+  // in the per-thread search buffers until the next search
+  template <typename Weight>
+  const SearchSide<Weight>& ComputeShortestPathTree(const DirectedWeightedGraph<Weight>& graph, VertexId source) {
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(graph.GetVertexCount());
+    search.Reach(source, Weight{0}, std::numeric_limits<EdgeId>::max());
+    while (!search.queue.empty()) {
+      const auto [distance, vertex] = search.PopQueue();
+      if (distance > search.distances[vertex]) {
+        continue;  // stale item
+      }
+      for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+        const Weight candidate = distance + arc.weight;
+        if (!search.IsReached(arc.to) || candidate < search.distances[arc.to]) {
+          search.Reach(arc.to, candidate, arc.edge_id);
+        }
+      }
+    }
+    return search;
+  }
+
+  // One search from source until the weight of every target is final, weights go to row.
+  // Search state lives in the per-thread buffers, targets are checked in order: a reached
+  // target is final once the search pops a vertex at least as far, as weights are non negative.
+  template <typename Weight>
+  void ComputeOneToManyWeights(const DirectedWeightedGraph<Weight>& graph, VertexId source,
+                               const std::vector<VertexId>& targets, std::optional<Weight>* row) {
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(graph.GetVertexCount());
+    search.Reach(source, Weight{0}, std::numeric_limits<EdgeId>::max());
+    size_t final_target_count = 0;
+    while (!search.queue.empty()) {
+      const auto [distance, vertex] = search.PopQueue();
+      if (distance > search.distances[vertex]) {
+        continue;  // stale item
+      }
+      while (final_target_count < targets.size() && search.IsReached(targets[final_target_count])
+             && search.distances[targets[final_target_count]] <= distance) {
+        ++final_target_count;
+      }
+      if (final_target_count == targets.size()) {
+        break;
+      }
+
+      for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+        const Weight candidate = distance + arc.weight;
+        if (!search.IsReached(arc.to) || candidate < search.distances[arc.to]) {
+          search.Reach(arc.to, candidate, arc.edge_id);
+        }
+      }
+    }
+
+    for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+      const VertexId target = targets[target_idx];
+      row[target_idx] = search.IsReached(target) ? std::optional<Weight>(search.distances[target]) : std::nullopt;
+    }
+  }
+
+  // Vertices reachable from source within max_weight with their distances, in settling order.
+  // The search stops as soon as the closest unsettled vertex is farther than max_weight.
+  // Search state lives in the per-thread buffers, a vertex settles at its first not stale pop.
+  template <typename Weight>
+  std::vector<std::pair<VertexId, Weight>> ComputeWeightsWithin(const DirectedWeightedGraph<Weight>& graph,
+                                                                VertexId source, Weight max_weight) {
+    std::vector<std::pair<VertexId, Weight>> settled_vertices;
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(graph.GetVertexCount());
+    search.Reach(source, Weight{0}, std::numeric_limits<EdgeId>::max());
+    while (!search.queue.empty() && search.queue.front().first <= max_weight) {
+      const auto [distance, vertex] = search.PopQueue();
+      if (distance > search.distances[vertex]) {
+        continue;  // stale item
+      }
+      settled_vertices.push_back({vertex, distance});
+
+      for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+        const Weight candidate = distance + arc.weight;
+        if (candidate <= max_weight && (!search.IsReached(arc.to) || candidate < search.distances[arc.to])) {
+          search.Reach(arc.to, candidate, arc.edge_id);
+        }
+      }
+    }
+    return settled_vertices;
+  }
+
+  template <typename Weight>
+  DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+      : graph_(graph)
+  {
+  }
+
+  template <typename Weight>
+  std::optional<Weight> DijkstraRouter<Weight>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    return ComputeShortestPath(graph_, from, to, [](const Arc<Weight>& arc) { return arc.weight; }, edges);
+  }
+
+  template <typename Weight>
+  void DijkstraRouter<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                                   std::vector<std::optional<Weight>>& table) const {
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      ComputeOneToManyWeights(graph_, sources[source_idx], targets, table.data() + source_idx * targets.size());
+    }
+  }
+
+}
@@ -2,14 +2,21 @@
 
 #include "Utils.h"
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <deque>
+#include <iterator>
+#include <limits>
 #include <vector>
 
 namespace Graph {
 
   using VertexId = size_t;
   using EdgeId = size_t;
+  // Ids as stored by the graph, graphs are limited to 2^32 - 1 vertices and edges
+  using CompactId = uint32_t;
 
   template <typename Weight>
   struct Edge {
@@ -18,57 +25,170 @@ namespace Graph {
     Weight weight;
   };
 
+  // Outgoing edge of a vertex in a frozen graph
+  template <typename Weight>
+  struct Arc {
+    VertexId to;
+    Weight weight;
+    EdgeId edge_id;
+  };
+
   template <typename Weight>
   class DirectedWeightedGraph {
   private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = Range<typename IncidenceList::const_iterator>;
+    using IncidenceList = std::vector<CompactId>;
+    using IncidentEdgesRange = Range<const CompactId*>;
 
   public:
+    class ArcIterator;
+    using ArcsRange = Range<ArcIterator>;
+
     DirectedWeightedGraph(size_t vertex_count = 0);
     EdgeId AddEdge(const Edge<Weight>& edge);
 
+    // Replaces incidence lists with the compressed sparse row layout: arcs of vertex v are
+    // [arc_begins_[v], arc_begins_[v + 1]) of the parallel heads, weights and edge ids arrays,
+    // in the order the edges were added. The edges themselves are dropped, an edge is read
+    // back from its arc and tail. No edges can be added afterwards.
+    void Freeze();
+    bool IsFrozen() const;
+
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    // Frozen graph only: sequential reads of the vertex arcs, no edge lookups
+    ArcsRange GetOutgoingArcs(VertexId vertex) const;
 
   private:
-    std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    size_t vertex_count_;
+    std::vector<Edge<Weight>> edges_;  // until frozen
+    std::vector<IncidenceList> incidence_lists_;  // until frozen
+
+    std::vector<CompactId> arc_begins_;
+    std::vector<CompactId> arc_heads_;
+    std::vector<Weight> arc_weights_;
+    std::vector<CompactId> arc_edge_ids_;
+    std::vector<CompactId> edge_arcs_;  // arc of edge
+    std::vector<CompactId> edge_tails_;
+  };
+
+  template <typename Weight>
+  class DirectedWeightedGraph<Weight>::ArcIterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Arc<Weight>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Arc<Weight>;
+
+    ArcIterator(const DirectedWeightedGraph& graph, size_t arc_idx) : graph_(&graph), arc_idx_(arc_idx) {}
+
+    Arc<Weight> operator*() const {
+      return {graph_->arc_heads_[arc_idx_], graph_->arc_weights_[arc_idx_], graph_->arc_edge_ids_[arc_idx_]};
+    }
+    ArcIterator& operator++() {
+      ++arc_idx_;
+      return *this;
+    }
+    bool operator==(const ArcIterator& other) const {
+      return arc_idx_ == other.arc_idx_;
+    }
+    bool operator!=(const ArcIterator& other) const {
+      return arc_idx_ != other.arc_idx_;
+    }
+
+  private:
+    const DirectedWeightedGraph* graph_;
+    size_t arc_idx_;
   };
 
 
   template <typename Weight>
-  DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count) : incidence_lists_(vertex_count) {}
+  DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
+      : vertex_count_(vertex_count),
+        incidence_lists_(vertex_count)
+  {
+  }
 
   template <typename Weight>
   EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    assert(!IsFrozen());
+    assert(edge.from < vertex_count_ && edge.to < vertex_count_);
+    assert(edges_.size() < std::numeric_limits<CompactId>::max());
     edges_.push_back(edge);
     const EdgeId id = edges_.size() - 1;
-    incidence_lists_[edge.from].push_back(id);
+    incidence_lists_[edge.from].push_back(static_cast<CompactId>(id));
     return id;
   }
 
+  template <typename Weight>
+  void DirectedWeightedGraph<Weight>::Freeze() {
+    if (IsFrozen()) {
+      return;
+    }
+    assert(vertex_count_ < std::numeric_limits<CompactId>::max());
+    const size_t edge_count = edges_.size();
+    arc_begins_.assign(vertex_count_ + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      arc_begins_[vertex + 1] = arc_begins_[vertex] + static_cast<CompactId>(incidence_lists_[vertex].size());
+    }
+    arc_heads_.reserve(edge_count);
+    arc_weights_.reserve(edge_count);
+    arc_edge_ids_.reserve(edge_count);
+    edge_arcs_.resize(edge_count);
+    edge_tails_.resize(edge_count);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+      for (const CompactId edge_id : incidence_lists_[vertex]) {
+        edge_arcs_[edge_id] = static_cast<CompactId>(arc_heads_.size());
+        edge_tails_[edge_id] = static_cast<CompactId>(vertex);
+        arc_heads_.push_back(static_cast<CompactId>(edges_[edge_id].to));
+        arc_weights_.push_back(edges_[edge_id].weight);
+        arc_edge_ids_.push_back(edge_id);
+      }
+    }
+    std::vector<IncidenceList>().swap(incidence_lists_);
+    std::vector<Edge<Weight>>().swap(edges_);
+  }
+
+  template <typename Weight>
+  bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return !arc_begins_.empty();
+  }
+
   template <typename Weight>
   size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
   }
 
   template <typename Weight>
   size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return IsFrozen() ? edge_arcs_.size() : edges_.size();
   }
 
   template <typename Weight>
-  const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+  Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    if (IsFrozen()) {
+      const CompactId arc_idx = edge_arcs_[edge_id];
+      return {edge_tails_[edge_id], arc_heads_[arc_idx], arc_weights_[arc_idx]};
+    }
     return edges_[edge_id];
   }
 
   template <typename Weight>
   typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
   DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+    if (IsFrozen()) {
+      return {arc_edge_ids_.data() + arc_begins_[vertex], arc_edge_ids_.data() + arc_begins_[vertex + 1]};
+    }
     const auto& edges = incidence_lists_[vertex];
-    return {std::begin(edges), std::end(edges)};
+    return {edges.data(), edges.data() + edges.size()};
+  }
+
+  template <typename Weight>
+  typename DirectedWeightedGraph<Weight>::ArcsRange
+  DirectedWeightedGraph<Weight>::GetOutgoingArcs(VertexId vertex) const {
+    assert(IsFrozen());
+    return {ArcIterator(*this, arc_begins_[vertex]), ArcIterator(*this, arc_begins_[vertex + 1])};
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "DijkstraRouter.h"
+#include "Graph.h"
+#include "IRouter.h"
+#include "SearchScratch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Hub labeling: every vertex keeps distances to (out label) and from (in label) a few hubs
+  // so that some hub on every shortest path is in both labels of its ends. A route weight is
+  // a linear merge of two labels sorted by hub, no search at all. Labels are built by pruned
+  // Dijkstra searches from hubs in decreasing degree order. Only weights tables are merged:
+  // a route with its edges still runs a plain Dijkstra search, skipped when the labels tell
+  // there is no route.
+  template <typename Weight>
+  class HubLabelRouter : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    // Labels of vertex v are [label_begins[v], label_begins[v + 1]) of the hubs and distances,
+    // sorted by hub rank
+    struct Labels {
+      std::vector<uint32_t> label_begins;
+      std::vector<uint32_t> hubs;  // ranks of hubs
+      std::vector<Weight> distances;
+    };
+
+    struct LabelsData {
+      Labels out_labels;  // d(vertex, hub)
+      Labels in_labels;  // d(hub, vertex)
+    };
+
+    explicit HubLabelRouter(const Graph& graph);
+    // Restores previously computed labels
+    HubLabelRouter(const Graph& graph, LabelsData data);
+
+    // Route weight from the labels only
+    std::optional<Weight> FindWeight(VertexId from, VertexId to) const;
+
+    const LabelsData& GetLabelsData() const;
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
+    void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                             std::vector<std::optional<Weight>>& table) const override;
+
+  private:
+    static constexpr EdgeId NoEdge = std::numeric_limits<EdgeId>::max();
+    static constexpr Weight NoRoute = std::numeric_limits<Weight>::max();
+
+    using LabelLists = std::vector<std::vector<std::pair<uint32_t, Weight>>>;
+
+    // Pruned search from the hub in the arcs direction: vertices whose labels already give
+    // a route as short are neither labeled nor expanded
+    template <typename GetArcs>
+    static void AddHubLabels(VertexId hub, uint32_t hub_rank, size_t vertex_count, GetArcs get_arcs,
+                             const std::vector<std::pair<uint32_t, Weight>>& hub_label,
+                             std::vector<Weight>& hub_distances, LabelLists& labels);
+
+    static Labels Flatten(const LabelLists& labels);
+
+    const Graph& graph_;
+    LabelsData data_;
+  };
+
+
+  template <typename Weight>
+  HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph)
+      : graph_(graph)
+  {
+    const size_t vertex_count = graph.GetVertexCount();
+    // Reversed arcs, 'to' is the edge tail
+    std::vector<std::vector<Arc<Weight>>> incoming_arcs(vertex_count);
+    std::vector<size_t> degrees(vertex_count, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+      const auto& edge = graph.GetEdge(edge_id);
+      incoming_arcs[edge.to].push_back({edge.from, edge.weight, edge_id});
+      ++degrees[edge.from];
+      ++degrees[edge.to];
+    }
+
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](VertexId lhs, VertexId rhs) {
+      return degrees[lhs] > degrees[rhs];
+    });
+
+    LabelLists out_labels(vertex_count);
+    LabelLists in_labels(vertex_count);
+    std::vector<Weight> hub_distances(vertex_count, NoRoute);  // by rank, of the current hub label
+    for (uint32_t rank = 0; rank < vertex_count; ++rank) {
+      const VertexId hub = order[rank];
+      // Forward search gives d(hub, v) for in labels, pruned by the hub's out label
+      AddHubLabels(hub, rank, vertex_count, [&](VertexId vertex) { return graph.GetOutgoingArcs(vertex); },
+                   out_labels[hub], hub_distances, in_labels);
+      AddHubLabels(hub, rank, vertex_count, [&](VertexId vertex) { return AsRange(incoming_arcs[vertex]); },
+                   in_labels[hub], hub_distances, out_labels);
+    }
+    data_.out_labels = Flatten(out_labels);
+    data_.in_labels = Flatten(in_labels);
+  }
+
+  template <typename Weight>
+  HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, LabelsData data)
+      : graph_(graph),
+        data_(std::move(data))
+  {
+    assert(data_.out_labels.label_begins.size() == graph.GetVertexCount() + 1);
+    assert(data_.in_labels.label_begins.size() == graph.GetVertexCount() + 1);
+  }
+
+  template <typename Weight>
+  template <typename GetArcs>
+  void HubLabelRouter<Weight>::AddHubLabels(VertexId hub, uint32_t hub_rank, size_t vertex_count, GetArcs get_arcs,
+                                            const std::vector<std::pair<uint32_t, Weight>>& hub_label,
+                                            std::vector<Weight>& hub_distances, LabelLists& labels) {
+    for (const auto& [rank, distance] : hub_label) {
+      hub_distances[rank] = distance;
+    }
+
+    SearchSide<Weight>& search = SearchScratch<Weight>::Get().forward;
+    search.StartQuery(vertex_count);
+    search.Reach(hub, Weight{0}, NoEdge);
+    while (!search.queue.empty()) {
+      const auto [distance, vertex] = search.PopQueue();
+      if (distance > search.distances[vertex]) {
+        continue;  // stale item
+      }
+      bool is_covered = false;
+      for (const auto& [rank, label_distance] : labels[vertex]) {
+        if (hub_distances[rank] != NoRoute && hub_distances[rank] + label_distance <= distance) {
+          is_covered = true;
+          break;
+        }
+      }
+      if (is_covered) {
+        continue;
+      }
+      labels[vertex].push_back({hub_rank, distance});
+
+      for (const Arc<Weight> arc : get_arcs(vertex)) {
+        const Weight candidate = distance + arc.weight;
+        if (!search.IsReached(arc.to) || candidate < search.distances[arc.to]) {
+          search.Reach(arc.to, candidate, arc.edge_id);
+        }
+      }
+    }
+
+    for (const auto& [rank, _] : hub_label) {
+      hub_distances[rank] = NoRoute;
+    }
+  }
+
+  template <typename Weight>
+  typename HubLabelRouter<Weight>::Labels HubLabelRouter<Weight>::Flatten(const LabelLists& labels) {
+    Labels flat;
+    flat.label_begins.reserve(labels.size() + 1);
+    flat.label_begins.push_back(0);
+    for (const auto& label : labels) {
+      flat.label_begins.push_back(flat.label_begins.back() + label.size());
+    }
+    flat.hubs.reserve(flat.label_begins.back());
+    flat.distances.reserve(flat.label_begins.back());
+    for (const auto& label : labels) {
+      for (const auto& [rank, distance] : label) {
+        flat.hubs.push_back(rank);
+        flat.distances.push_back(distance);
+      }
+    }
+    return flat;
+  }
+
+  template <typename Weight>
+  std::optional<Weight> HubLabelRouter<Weight>::FindWeight(VertexId from, VertexId to) const {
+    const Labels& out_labels = data_.out_labels;
+    const Labels& in_labels = data_.in_labels;
+    uint32_t out_idx = out_labels.label_begins[from];
+    const uint32_t out_end = out_labels.label_begins[from + 1];
+    uint32_t in_idx = in_labels.label_begins[to];
+    const uint32_t in_end = in_labels.label_begins[to + 1];
+
+    Weight best_weight = NoRoute;
+    while (out_idx < out_end && in_idx < in_end) {
+      const uint32_t out_hub = out_labels.hubs[out_idx];
+      const uint32_t in_hub = in_labels.hubs[in_idx];
+      if (out_hub < in_hub) {
+        ++out_idx;
+      }
+      else if (in_hub < out_hub) {
+        ++in_idx;
+      }
+      else {
+        best_weight = std::min(best_weight, out_labels.distances[out_idx++] + in_labels.distances[in_idx++]);
+      }
+    }
+    if (best_weight == NoRoute) {
+      return std::nullopt;
+    }
+    return best_weight;
+  }
+
+  template <typename Weight>
+  const typename HubLabelRouter<Weight>::LabelsData& HubLabelRouter<Weight>::GetLabelsData() const {
+    return data_;
+  }
+
+  template <typename Weight>
+  std::optional<Weight> HubLabelRouter<Weight>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    if (!FindWeight(from, to)) {
+      return std::nullopt;
+    }
+    return ComputeShortestPath(graph_, from, to, [](const Arc<Weight>& arc) { return arc.weight; }, edges);
+  }
+
+  template <typename Weight>
+  void HubLabelRouter<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                                   std::vector<std::optional<Weight>>& table) const {
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+        table[source_idx * targets.size() + target_idx] = FindWeight(sources[source_idx], targets[target_idx]);
+      }
+    }
+  }
+
+}
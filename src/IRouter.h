@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Graph {
+
+  // Common interface of all shortest path engines.
+  // Routers keep no per-query state, so one router serves queries from many threads at once.
+  template <typename Weight>
+  class IRouter {
+  public:
+    IRouter() = default;
+    virtual ~IRouter() = default;
+
+    // Route weight, edges are replaced with the route edges in order from 'from' to 'to'.
+    // Reusing the same edges buffer across queries avoids allocations.
+    std::optional<Weight> FindRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    // Row-major sources x targets table of route weights, nullopt for missing routes
+    std::vector<std::optional<Weight>> BuildWeightsTable(const std::vector<VertexId>& sources,
+                                                         const std::vector<VertexId>& targets) const;
+
+  protected:
+    // Fills edges with the route edges in order from 'from' to 'to'
+    virtual std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const = 0;
+
+    // Answers every pair separately, good enough for engines with precomputed tables only
+    virtual void ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                     std::vector<std::optional<Weight>>& table) const;
+  };
+
+  template <typename Weight>
+  using IRouterUnp = std::unique_ptr<IRouter<Weight>>;
+
+
+  template <typename Weight>
+  std::optional<Weight> IRouter<Weight>::FindRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    return ComputeRoute(from, to, edges);
+  }
+
+  template <typename Weight>
+  std::vector<std::optional<Weight>> IRouter<Weight>::BuildWeightsTable(const std::vector<VertexId>& sources,
+                                                                        const std::vector<VertexId>& targets) const {
+    std::vector<std::optional<Weight>> table(sources.size() * targets.size());
+    ComputeWeightsTable(sources, targets, table);
+    return table;
+  }
+
+  template <typename Weight>
+  void IRouter<Weight>::ComputeWeightsTable(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets,
+                                            std::vector<std::optional<Weight>>& table) const {
+    std::vector<EdgeId> edges;
+    for (size_t source_idx = 0; source_idx < sources.size(); ++source_idx) {
+      for (size_t target_idx = 0; target_idx < targets.size(); ++target_idx) {
+        table[source_idx * targets.size() + target_idx] = ComputeRoute(sources[source_idx], targets[target_idx], edges);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "AStarRouter.h"
+#include "Graph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // ALT: A* with landmarks and the triangle inequality. Distances to and from a few landmarks
+  // are computed once; d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L) give
+  // a lower bound for any weights, no matter how they relate to geography.
+  template <typename Weight>
+  class LandmarkRouter : public AStarRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    static constexpr Weight NoRoute = std::numeric_limits<Weight>::max();
+
+    struct LandmarksData {
+      std::vector<VertexId> landmarks;
+      // Vertex-major vertex_count x landmark_count tables, NoRoute for unreachable pairs
+      std::vector<Weight> from_landmarks;  // d(landmark, vertex)
+      std::vector<Weight> to_landmarks;  // d(vertex, landmark)
+    };
+
+    LandmarkRouter(const Graph& graph, const std::vector<VertexId>& landmarks);
+    // Restores previously computed landmark distances
+    LandmarkRouter(const Graph& graph, LandmarksData data);
+
+    // Farthest-first selection: every next landmark is the candidate with the longest
+    // round trip to the closest already selected one
+    static std::vector<VertexId> SelectFarthestLandmarks(const Graph& graph,
+                                                         const std::vector<VertexId>& candidates,
+                                                         size_t landmark_count);
+
+    const LandmarksData& GetLandmarksData() const;
+
+  private:
+    class DistancesComputer;
+
+    Weight ComputePotential(VertexId vertex, VertexId to) const;
+
+    LandmarksData data_;
+  };
+
+
+  // One-to-all Dijkstra over the graph or its reversal
+  template <typename Weight>
+  class LandmarkRouter<Weight>::DistancesComputer {
+  public:
+    explicit DistancesComputer(const Graph& graph)
+        : graph_(graph),
+          incoming_arcs_(graph.GetVertexCount())
+    {
+      for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        incoming_arcs_[edge.to].push_back({edge.from, edge.weight, edge_id});
+      }
+    }
+
+    std::vector<Weight> ComputeFrom(VertexId source) const {
+      return Compute(source, [this](VertexId vertex) { return graph_.GetOutgoingArcs(vertex); });
+    }
+
+    std::vector<Weight> ComputeTo(VertexId target) const {
+      return Compute(target, [this](VertexId vertex) { return AsRange(incoming_arcs_[vertex]); });
+    }
+
+  private:
+    // Arcs of a vertex in the search direction, their 'to' is the next vertex
+    template <typename GetArcs>
+    std::vector<Weight> Compute(VertexId source, GetArcs get_arcs) const {
+      std::vector<Weight> distances(graph_.GetVertexCount(), NoRoute);
+      using QueueItem = std::pair<Weight, VertexId>;
+      std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+      distances[source] = Weight{0};
+      queue.push({Weight{0}, source});
+      while (!queue.empty()) {
+        const auto [distance, vertex] = queue.top();
+        queue.pop();
+        if (distance > distances[vertex]) {
+          continue;
+        }
+        for (const Arc<Weight> arc : get_arcs(vertex)) {
+          const Weight candidate = distance + arc.weight;
+          if (candidate < distances[arc.to]) {
+            distances[arc.to] = candidate;
+            queue.push({candidate, arc.to});
+          }
+        }
+      }
+      return distances;
+    }
+
+    const Graph& graph_;
+    std::vector<std::vector<Arc<Weight>>> incoming_arcs_;  // reversed, 'to' is the edge tail
+  };
+
+
+  template <typename Weight>
+  LandmarkRouter<Weight>::LandmarkRouter(const Graph& graph, const std::vector<VertexId>& landmarks)
+      : AStarRouter<Weight>(graph, [this](VertexId vertex, VertexId to) { return ComputePotential(vertex, to); })
+  {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t landmark_count = landmarks.size();
+    data_.landmarks = landmarks;
+    data_.from_landmarks.resize(vertex_count * landmark_count);
+    data_.to_landmarks.resize(vertex_count * landmark_count);
+
+    const DistancesComputer computer(graph);
+    for (size_t landmark_idx = 0; landmark_idx < landmark_count; ++landmark_idx) {
+      const auto from_distances = computer.ComputeFrom(landmarks[landmark_idx]);
+      const auto to_distances = computer.ComputeTo(landmarks[landmark_idx]);
+      for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        data_.from_landmarks[vertex * landmark_count + landmark_idx] = from_distances[vertex];
+        data_.to_landmarks[vertex * landmark_count + landmark_idx] = to_distances[vertex];
+      }
+    }
+  }
+
+  template <typename Weight>
+  LandmarkRouter<Weight>::LandmarkRouter(const Graph& graph, LandmarksData data)
+      : AStarRouter<Weight>(graph, [this](VertexId vertex, VertexId to) { return ComputePotential(vertex, to); }),
+        data_(std::move(data))
+  {
+    assert(data_.from_landmarks.size() == graph.GetVertexCount() * data_.landmarks.size());
+    assert(data_.to_landmarks.size() == data_.from_landmarks.size());
+  }
+
+  template <typename Weight>
+  std::vector<VertexId> LandmarkRouter<Weight>::SelectFarthestLandmarks(const Graph& graph,
+                                                                        const std::vector<VertexId>& candidates,
+                                                                        size_t landmark_count) {
+    std::vector<VertexId> landmarks;
+    if (candidates.empty()) {
+      return landmarks;
+    }
+    landmark_count = std::min(landmark_count, candidates.size());
+    landmarks.reserve(landmark_count);
+
+    const DistancesComputer computer(graph);
+    // Round trip to the closest selected vertex, candidates not connected to any of them go first
+    std::vector<Weight> round_trips(candidates.size(), NoRoute);
+    auto add_round_trips = [&](VertexId vertex) {
+      const auto from_distances = computer.ComputeFrom(vertex);
+      const auto to_distances = computer.ComputeTo(vertex);
+      for (size_t idx = 0; idx < candidates.size(); ++idx) {
+        const Weight from_distance = from_distances[candidates[idx]];
+        const Weight to_distance = to_distances[candidates[idx]];
+        if (from_distance != NoRoute && to_distance != NoRoute) {
+          round_trips[idx] = std::min(round_trips[idx], from_distance + to_distance);
+        }
+      }
+    };
+
+    // The first landmark is the farthest from the first candidate
+    add_round_trips(candidates.front());
+    while (landmarks.size() < landmark_count) {
+      const auto best_it = std::max_element(round_trips.begin(), round_trips.end());
+      if (*best_it == Weight{0}) {
+        break;  // every candidate is already as close as possible
+      }
+      landmarks.push_back(candidates[best_it - round_trips.begin()]);
+      if (landmarks.size() == 1) {
+        round_trips.assign(candidates.size(), NoRoute);
+      }
+      add_round_trips(landmarks.back());
+    }
+    return landmarks;
+  }
+
+  template <typename Weight>
+  const typename LandmarkRouter<Weight>::LandmarksData& LandmarkRouter<Weight>::GetLandmarksData() const {
+    return data_;
+  }
+
+  template <typename Weight>
+  Weight LandmarkRouter<Weight>::ComputePotential(VertexId vertex, VertexId to) const {
+    const size_t landmark_count = data_.landmarks.size();
+    const Weight* from_vertex = data_.from_landmarks.data() + vertex * landmark_count;
+    const Weight* from_target = data_.from_landmarks.data() + to * landmark_count;
+    const Weight* to_vertex = data_.to_landmarks.data() + vertex * landmark_count;
+    const Weight* to_target = data_.to_landmarks.data() + to * landmark_count;
+
+    Weight potential{0};
+    for (size_t landmark_idx = 0; landmark_idx < landmark_count; ++landmark_idx) {
+      if (from_vertex[landmark_idx] != NoRoute && from_target[landmark_idx] != NoRoute) {
+        potential = std::max(potential, from_target[landmark_idx] - from_vertex[landmark_idx]);
+      }
+      if (to_vertex[landmark_idx] != NoRoute && to_target[landmark_idx] != NoRoute) {
+        potential = std::max(potential, to_vertex[landmark_idx] - to_target[landmark_idx]);
+      }
+    }
+    return potential;
+  }
+
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iomanip>
 #include "Descriptions.h"
 #include "Json.h"
@@ -57,6 +58,12 @@ void Program::ProcessRequests(std::istream& in, std::ostream& out)
 
     auto [transportDb, yellowPagesDb] = Serialization::ProtoSerializer::Deserialize(serializationSettings);
 
+    const auto& statRequests = inputMap.at("stat_requests").AsArray();
+    const size_t routeRequestCount = std::count_if(statRequests.begin(), statRequests.end(), [](const Json::Node& request) {
+        return request.AsMap().at("type").AsString() == "Route";
+    });
+    transportDb->SelectRoutingEngine(routeRequestCount);
+
     const auto mapVisualizer = std::make_shared<Svg::MapVisualizer>(transportDb->GetStopsDescriptions(),
         transportDb->GetBusesDescriptions(),
         transportDb->GetRenderSettings());
@@ -69,7 +76,7 @@ void Program::ProcessRequests(std::istream& in, std::ostream& out)
 
     out << std::fixed << std::setprecision(14);
     Json::PrintValue(
-        Requests::ProcessAll(context,inputMap.at("stat_requests").AsArray()),
+        Requests::ProcessAll(context, statRequests),
         out
     );
     out << endl;
@@ -0,0 +1,166 @@
+#include "RaptorRouter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+using namespace Router;
+
+RaptorRouter::RaptorRouter(size_t stop_count, const vector<BusLine>& bus_lines, const RoutingSettings& routing_settings)
+  : routing_settings_(routing_settings)
+{
+  line_begins_.reserve(bus_lines.size() + 1);
+  line_begins_.push_back(0);
+  for (const auto& bus_line : bus_lines) {
+    assert(bus_line.stops.size() == bus_line.distances.size());
+    line_stops_.insert(line_stops_.end(), bus_line.stops.begin(), bus_line.stops.end());
+    line_distances_.insert(line_distances_.end(), bus_line.distances.begin(), bus_line.distances.end());
+    line_begins_.push_back(line_stops_.size());
+  }
+
+  // Counting sort of line positions by their stops
+  stop_positions_begins_.assign(stop_count + 1, 0);
+  for (const uint32_t stop : line_stops_) {
+    ++stop_positions_begins_[stop + 1];
+  }
+  partial_sum(stop_positions_begins_.begin(), stop_positions_begins_.end(), stop_positions_begins_.begin());
+  stop_line_ids_.resize(line_stops_.size());
+  stop_positions_.resize(line_stops_.size());
+  vector<uint32_t> next_idxs(stop_positions_begins_.begin(), stop_positions_begins_.end() - 1);
+  for (uint32_t line_idx = 0; line_idx + 1 < line_begins_.size(); ++line_idx) {
+    for (uint32_t position = line_begins_[line_idx]; position < line_begins_[line_idx + 1]; ++position) {
+      const uint32_t idx = next_idxs[line_stops_[position]]++;
+      stop_line_ids_[idx] = line_idx;
+      stop_positions_[idx] = position;
+    }
+  }
+}
+
+optional<RaptorRouter::Journey> RaptorRouter::FindJourney(uint32_t stop_from, uint32_t stop_to) const {
+  return FindJourney(stop_from, stop_to, routing_settings_);
+}
+
+optional<RaptorRouter::Journey> RaptorRouter::FindJourney(uint32_t stop_from, uint32_t stop_to,
+  const RoutingSettings& metric) const {
+  if (stop_from == stop_to) {
+    return Journey{ .total_time = 0.0, .rides = {} };
+  }
+
+  const Rounds& rounds = RunRounds(stop_from, stop_to, metric);
+  if (rounds.best_times[stop_to] == numeric_limits<double>::infinity()) {
+    return nullopt;
+  }
+
+  // The last round improving the target holds its best arrival
+  size_t target_round = rounds.round_count;
+  while (rounds.labels[target_round - 1][stop_to].time != rounds.best_times[stop_to]) {
+    --target_round;
+  }
+
+  Journey journey = { .total_time = rounds.best_times[stop_to], .rides = {} };
+  journey.rides.reserve(target_round);
+  uint32_t stop = stop_to;
+  for (size_t round = target_round; round > 0; --round) {
+    const Label& label = rounds.labels[round - 1][stop];
+    journey.rides.push_back({ label.line_idx, label.board_position, label.alight_position });
+    stop = line_stops_[line_begins_[label.line_idx] + label.board_position];
+  }
+  assert(stop == stop_from);
+  reverse(journey.rides.begin(), journey.rides.end());
+  return journey;
+}
+
+vector<double> RaptorRouter::ComputeArrivalTimes(uint32_t stop_from) const {
+  return RunRounds(stop_from, nullopt, routing_settings_).best_times;
+}
+
+const RaptorRouter::Rounds& RaptorRouter::RunRounds(uint32_t stop_from, optional<uint32_t> stop_to,
+  const RoutingSettings& metric) const {
+  constexpr double NoTime = numeric_limits<double>::infinity();
+  const size_t stop_count = stop_positions_begins_.size() - 1;
+  const size_t line_count = line_begins_.size() - 1;
+  const double wait_time = metric.bus_wait_time;
+
+  static thread_local Rounds rounds;
+  rounds.round_count = 0;
+  vector<double>& best_times = rounds.best_times;
+  best_times.assign(stop_count, NoTime);
+  // Arrivals improved by the previous round, only they are worth boarding from.
+  // Every query leaves them infinite, so only entries past the previous size are set here.
+  vector<double>& previous_times = rounds.previous_times;
+  previous_times.resize(stop_count, NoTime);
+
+  vector<uint32_t>& marked_stops = rounds.marked_stops;
+  vector<uint32_t>& next_marked_stops = rounds.next_marked_stops;
+  vector<bool>& is_marked = rounds.is_marked;
+  is_marked.resize(stop_count, false);
+  vector<uint32_t>& line_first_positions = rounds.line_first_positions;
+  line_first_positions.resize(line_count, NoPosition);
+  vector<uint32_t>& scanned_lines = rounds.scanned_lines;
+  marked_stops.assign(1, stop_from);
+  best_times[stop_from] = 0.0;
+  previous_times[stop_from] = 0.0;
+
+  while (!marked_stops.empty()) {
+    // Lines through improved stops are scanned from the first of them
+    for (const uint32_t stop : marked_stops) {
+      for (uint32_t idx = stop_positions_begins_[stop]; idx < stop_positions_begins_[stop + 1]; ++idx) {
+        const uint32_t line_idx = stop_line_ids_[idx];
+        if (line_first_positions[line_idx] == NoPosition) {
+          scanned_lines.push_back(line_idx);
+        }
+        line_first_positions[line_idx] = min(line_first_positions[line_idx], stop_positions_[idx]);
+      }
+    }
+
+    if (rounds.round_count == rounds.labels.size()) {
+      rounds.labels.emplace_back();
+    }
+    auto& labels = rounds.labels[rounds.round_count++];
+    labels.assign(stop_count, Label{ NoTime, 0, 0, 0 });
+    for (const uint32_t line_idx : scanned_lines) {
+      const uint32_t line_begin = line_begins_[line_idx];
+      uint32_t board_position = NoPosition;
+      double board_key = NoTime;
+      for (uint32_t position = line_first_positions[line_idx]; position < line_begins_[line_idx + 1]; ++position) {
+        const uint32_t stop = line_stops_[position];
+        if (board_position != NoPosition) {
+          const double time = previous_times[line_stops_[board_position]] + wait_time +
+            metric.ComputeRideTime(line_distances_[position] - line_distances_[board_position]);
+          // Arrivals not better than the current one at the target can't lead to a better route
+          if (time < best_times[stop] && (!stop_to || time < best_times[*stop_to])) {
+            best_times[stop] = time;
+            labels[stop] = { time, line_idx, board_position - line_begin, position - line_begin };
+            if (!is_marked[stop]) {
+              is_marked[stop] = true;
+              next_marked_stops.push_back(stop);
+            }
+          }
+        }
+        if (previous_times[stop] != NoTime) {
+          // Boarding here is better if it saves more than the ride from the current boarding stop
+          const double key = previous_times[stop] + wait_time - metric.ComputeRideTime(line_distances_[position]);
+          if (key < board_key) {
+            board_key = key;
+            board_position = position;
+          }
+        }
+      }
+      line_first_positions[line_idx] = NoPosition;
+    }
+    scanned_lines.clear();
+
+    for (const uint32_t stop : marked_stops) {
+      previous_times[stop] = NoTime;
+    }
+    for (const uint32_t stop : next_marked_stops) {
+      previous_times[stop] = labels[stop].time;
+      is_marked[stop] = false;
+    }
+    marked_stops.swap(next_marked_stops);
+    next_marked_stops.clear();
+  }
+  return rounds;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "TransportRouter.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Router
+{
+  // Round-based search (RAPTOR) over bus stop sequences, no graph is built.
+  // Round k finds the best arrivals with k rides; every ride costs a wait first,
+  // so the result is the same as for the shortest path in the transport graph.
+  class RaptorRouter {
+  public:
+    RaptorRouter(size_t stop_count, const std::vector<BusLine>& bus_lines, const RoutingSettings& routing_settings);
+
+    struct Ride {
+      size_t line_idx;
+      size_t board_position;
+      size_t alight_position;
+    };
+    struct Journey {
+      double total_time;
+      std::vector<Ride> rides;
+    };
+
+    std::optional<Journey> FindJourney(uint32_t stop_from, uint32_t stop_to) const;
+    // Rides cost bus_wait_time and bus_velocity of metric instead of the router's ones
+    std::optional<Journey> FindJourney(uint32_t stop_from, uint32_t stop_to, const RoutingSettings& metric) const;
+
+    // Best arrival at every stop, infinity for unreachable ones
+    std::vector<double> ComputeArrivalTimes(uint32_t stop_from) const;
+
+  private:
+    static constexpr uint32_t NoPosition = UINT32_MAX;
+
+    struct Label {
+      double time;
+      uint32_t line_idx;
+      uint32_t board_position;
+      uint32_t alight_position;
+    };
+
+    // Buffers of the thread's searches, they only grow and are reused across queries
+    struct Rounds {
+      std::vector<double> best_times;
+      std::vector<std::vector<Label>> labels;  // labels of round k are labels[k - 1], k <= round_count
+      size_t round_count = 0;
+
+      // Work state, back to empty, infinite or unset after every query
+      std::vector<double> previous_times;
+      std::vector<bool> is_marked;
+      std::vector<uint32_t> line_first_positions;
+      std::vector<uint32_t> marked_stops;
+      std::vector<uint32_t> next_marked_stops;
+      std::vector<uint32_t> scanned_lines;
+    };
+
+    // Runs rounds until no stop improves, arrivals not better than at stop_to are pruned.
+    // The result is valid until the next search on the thread.
+    const Rounds& RunRounds(uint32_t stop_from, std::optional<uint32_t> stop_to, const RoutingSettings& metric) const;
+
+    // Lines are stored back to back: stops and distances of line i are in
+    // [line_begins_[i], line_begins_[i + 1])
+    std::vector<uint32_t> line_begins_;
+    std::vector<uint32_t> line_stops_;
+    std::vector<int> line_distances_;
+    // Positions in lines of every stop: [stop_positions_begins_[s], stop_positions_begins_[s + 1])
+    std::vector<uint32_t> stop_positions_begins_;
+    std::vector<uint32_t> stop_line_ids_;
+    std::vector<uint32_t> stop_positions_;
+
+    RoutingSettings routing_settings_;
+  };
+}
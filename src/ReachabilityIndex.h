@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Answers whether a route may exist before any search starts. Strongly connected components
+  // are numbered by Tarjan's algorithm, so arcs between components only go to lower numbers:
+  // a vertex of a lower component never reaches a higher one, and vertices of different weak
+  // components never reach each other. When a bit per pair of components fits into
+  // max_bitset_bytes, reachability over the condensation is exact. Linear time and memory
+  // besides the bitsets.
+  template <typename Weight>
+  class ReachabilityIndex {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    static constexpr size_t DefaultMaxBitsetBytes = 16 << 20;
+
+    explicit ReachabilityIndex(const Graph& graph, size_t max_bitset_bytes = DefaultMaxBitsetBytes);
+
+    // False only if there is no route from 'from' to 'to', exact with the bitsets
+    bool MayReach(VertexId from, VertexId to) const;
+
+    size_t GetComponentCount() const;
+    bool IsExact() const;
+
+  private:
+    void ComputeStrongComponents(const Graph& graph);
+    void ComputeWeakComponents(const Graph& graph);
+    void ComputeReachableComponents(const Graph& graph);
+
+    size_t component_count_ = 0;
+    std::vector<uint32_t> components_;  // strong component of vertex, in reverse topological order
+    std::vector<uint32_t> weak_components_;  // of vertex
+    size_t words_per_row_ = 0;
+    std::vector<uint64_t> reachable_;  // bitset row of components reachable from a component, or empty
+  };
+
+
+  template <typename Weight>
+  ReachabilityIndex<Weight>::ReachabilityIndex(const Graph& graph, size_t max_bitset_bytes) {
+    ComputeStrongComponents(graph);
+    ComputeWeakComponents(graph);
+    words_per_row_ = (component_count_ + 63) / 64;
+    if (component_count_ * words_per_row_ * sizeof(uint64_t) <= max_bitset_bytes) {
+      ComputeReachableComponents(graph);
+    }
+  }
+
+  template <typename Weight>
+  void ReachabilityIndex<Weight>::ComputeStrongComponents(const Graph& graph) {
+    // Iterative Tarjan: a frame per vertex on the depth-first path with its next arc
+    const size_t vertex_count = graph.GetVertexCount();
+    constexpr uint32_t NotVisited = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> order(vertex_count, NotVisited);
+    std::vector<uint32_t> low(vertex_count);
+    std::vector<bool> on_stack(vertex_count, false);
+    std::vector<VertexId> stack;
+    using ArcIterator = typename Graph::ArcIterator;
+    std::vector<std::pair<VertexId, ArcIterator>> path;
+    components_.assign(vertex_count, 0);
+    uint32_t next_order = 0;
+
+    auto visit = [&](VertexId vertex) {
+      order[vertex] = low[vertex] = next_order++;
+      stack.push_back(vertex);
+      on_stack[vertex] = true;
+      path.push_back({vertex, graph.GetOutgoingArcs(vertex).begin()});
+    };
+
+    for (VertexId root = 0; root < vertex_count; ++root) {
+      if (order[root] != NotVisited) {
+        continue;
+      }
+      visit(root);
+      while (!path.empty()) {
+        auto& [vertex, arc_it] = path.back();
+        if (arc_it != graph.GetOutgoingArcs(vertex).end()) {
+          const VertexId next = (*arc_it).to;
+          ++arc_it;
+          if (order[next] == NotVisited) {
+            visit(next);  // invalidates vertex and arc_it
+          }
+          else if (on_stack[next]) {
+            low[vertex] = std::min(low[vertex], order[next]);
+          }
+          continue;
+        }
+
+        const VertexId finished = vertex;
+        path.pop_back();
+        if (!path.empty()) {
+          const VertexId parent = path.back().first;
+          low[parent] = std::min(low[parent], low[finished]);
+        }
+        if (low[finished] == order[finished]) {
+          VertexId member;
+          do {
+            member = stack.back();
+            stack.pop_back();
+            on_stack[member] = false;
+            components_[member] = static_cast<uint32_t>(component_count_);
+          } while (member != finished);
+          ++component_count_;
+        }
+      }
+    }
+  }
+
+  template <typename Weight>
+  void ReachabilityIndex<Weight>::ComputeWeakComponents(const Graph& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<uint32_t> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), 0);
+    auto find_root = [&parents](uint32_t vertex) {
+      while (parents[vertex] != vertex) {
+        parents[vertex] = parents[parents[vertex]];  // path halving
+        vertex = parents[vertex];
+      }
+      return vertex;
+    };
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+      const auto& edge = graph.GetEdge(edge_id);
+      const uint32_t from_root = find_root(edge.from);
+      const uint32_t to_root = find_root(edge.to);
+      if (from_root != to_root) {
+        parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+      }
+    }
+    weak_components_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      weak_components_[vertex] = find_root(vertex);
+    }
+  }
+
+  template <typename Weight>
+  void ReachabilityIndex<Weight>::ComputeReachableComponents(const Graph& graph) {
+    // Arcs leave a component to lower numbers only, so rows are complete in increasing order
+    std::vector<std::vector<VertexId>> members(component_count_);
+    for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+      members[components_[vertex]].push_back(vertex);
+    }
+    reachable_.assign(component_count_ * words_per_row_, 0);
+    constexpr size_t NoComponent = std::numeric_limits<size_t>::max();
+    std::vector<size_t> merged_into(component_count_, NoComponent);  // row a component was last merged into
+    for (size_t component = 0; component < component_count_; ++component) {
+      uint64_t* row = reachable_.data() + component * words_per_row_;
+      row[component / 64] |= uint64_t{1} << (component % 64);
+      for (const VertexId vertex : members[component]) {
+        for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+          const size_t next = components_[arc.to];
+          if (next == component || merged_into[next] == component) {
+            continue;
+          }
+          merged_into[next] = component;
+          const uint64_t* next_row = reachable_.data() + next * words_per_row_;
+          for (size_t word = 0; word < words_per_row_; ++word) {
+            row[word] |= next_row[word];
+          }
+        }
+      }
+    }
+  }
+
+  template <typename Weight>
+  bool ReachabilityIndex<Weight>::MayReach(VertexId from, VertexId to) const {
+    const uint32_t from_component = components_[from];
+    const uint32_t to_component = components_[to];
+    if (from_component == to_component) {
+      return true;
+    }
+    if (from_component < to_component || weak_components_[from] != weak_components_[to]) {
+      return false;
+    }
+    if (reachable_.empty()) {
+      return true;
+    }
+    return reachable_[from_component * words_per_row_ + to_component / 64] >> (to_component % 64) & 1;
+  }
+
+  template <typename Weight>
+  size_t ReachabilityIndex<Weight>::GetComponentCount() const {
+    return component_count_;
+  }
+
+  template <typename Weight>
+  bool ReachabilityIndex<Weight>::IsExact() const {
+    return !reachable_.empty() || component_count_ == 0;
+  }
+
+}
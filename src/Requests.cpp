@@ -1,3 +1,4 @@
+#include <cassert>
 #include <vector>
 #include <sstream>
 
@@ -149,13 +150,16 @@ namespace
       return dict;
     }
 
+    // Names of route items are resolved by the router only here, when the response is built
     struct RouteItemResponseBuilder
     {
+      const TransportRouter &router;
+
       Json::Dict operator()(const TransportRouter::RouteInfo::BusItem &bus_item) const
       {
         return Json::Dict{
             {"type", Json::Node("Bus"s)},
-            {"bus", Json::Node(bus_item.bus_name)},
+            {"bus", Json::Node(router.GetBusName(bus_item.bus_id))},
             {"time", Json::Node(bus_item.time)},
             {"span_count", Json::Node(static_cast<int>(bus_item.span_count))}};
       }
@@ -163,15 +167,18 @@ namespace
       {
         return Json::Dict{
             {"type", Json::Node("Wait"s)},
-            {"stop_name", Json::Node(wait_item.stop_name)},
+            {"stop_name", Json::Node(router.GetStopName(wait_item.stop_id))},
             {"time", Json::Node(wait_item.time)},
         };
       }
     };
 
-    Route::Route(std::string stopFrom, std::string stopTo, ContextShp context) : _stopFrom(std::move(stopFrom)),
-                                                                                 _stopTo(std::move(stopTo)),
-                                                                                 _context(std::move(context))
+    Route::Route(std::string stopFrom, std::string stopTo, ContextShp context,
+                 std::optional<int> busWaitTime, std::optional<double> busVelocity) : _stopFrom(std::move(stopFrom)),
+                                                                                     _stopTo(std::move(stopTo)),
+                                                                                     _context(std::move(context)),
+                                                                                     _busWaitTime(busWaitTime),
+                                                                                     _busVelocity(busVelocity)
     {
     }
 
@@ -183,7 +190,25 @@ namespace
       }
 
       Json::Dict dict;
-      const auto route = _context->transportDb->FindRoute(_stopFrom, _stopTo);
+      optional<TransportRouter::RouteInfo> route;
+      if (_busWaitTime || _busVelocity)
+      {
+        RoutingSettings settings = _context->transportDb->GetRoutingSettings();
+        settings.bus_wait_time = _busWaitTime.value_or(settings.bus_wait_time);
+        settings.bus_velocity = _busVelocity.value_or(settings.bus_velocity);
+        if (!settings.HasValidMetric())
+        {
+#ifndef OnlyMap
+          dict["error_message"] = Json::Node("invalid routing settings"s);
+#endif
+          return dict;
+        }
+        route = _context->transportDb->FindRoute(_stopFrom, _stopTo, settings);
+      }
+      else
+      {
+        route = _context->transportDb->FindRoute(_stopFrom, _stopTo);
+      }
       if (!route)
       {
 #ifndef OnlyMap
@@ -198,7 +223,7 @@ namespace
         items.reserve(route->items.size());
         for (const auto &item : route->items)
         {
-          items.push_back(visit(RouteItemResponseBuilder{}, item));
+          items.push_back(visit(RouteItemResponseBuilder{_context->transportDb->GetRouter()}, item));
         }
 
         dict["items"] = std::move(items);
@@ -206,7 +231,7 @@ namespace
         std::stringstream mapSvg;
         if (_context->mapVisualizer != nullptr)
         {
-          _context->mapVisualizer->RenderRoute(mapSvg, *route, _stopTo);
+          _context->mapVisualizer->RenderRoute(mapSvg, _context->transportDb->GetRouter(), *route, _stopTo);
           dict["map"] = mapSvg.str();
         }
       }
@@ -214,6 +239,77 @@ namespace
       return dict;
     }
 
+    RouteMatrix::RouteMatrix(std::vector<std::string> stopsFrom,
+                             std::vector<std::string> stopsTo,
+                             TransportDatabaseShp transportDb) : _stopsFrom(std::move(stopsFrom)),
+                                                                 _stopsTo(std::move(stopsTo)),
+                                                                 _transportDb(std::move(transportDb))
+    {
+    }
+
+    Json::Dict RouteMatrix::Process() const
+    {
+      if (_transportDb == nullptr)
+      {
+        return {};
+      }
+
+      Json::Dict dict;
+#ifndef OnlyMap
+      // Rows follow "from" stops, columns follow "to" stops
+      const auto times = _transportDb->ComputeRouteTimes(_stopsFrom, _stopsTo);
+      vector<Json::Node> rows;
+      rows.reserve(times.size());
+      for (const auto &rowTimes : times)
+      {
+        vector<Json::Node> row;
+        row.reserve(rowTimes.size());
+        for (const auto &time : rowTimes)
+        {
+          row.push_back(time ? Json::Node(*time) : Json::Node("not found"s));
+        }
+        rows.emplace_back(std::move(row));
+      }
+      dict["total_times"] = Json::Node(std::move(rows));
+#endif
+      return dict;
+    }
+
+    Reachable::Reachable(std::string stopFrom, double maxTime, TransportDatabaseShp transportDb) : _stopFrom(std::move(stopFrom)),
+                                                                                                  _maxTime(maxTime),
+                                                                                                  _transportDb(std::move(transportDb))
+    {
+    }
+
+    Json::Dict Reachable::Process() const
+    {
+      if (_transportDb == nullptr)
+      {
+        return {};
+      }
+
+      Json::Dict dict;
+#ifndef OnlyMap
+      if (!_transportDb->GetStop(_stopFrom))
+      {
+        dict["error_message"] = Json::Node("not found"s);
+        return dict;
+      }
+      const auto reachableStops = _transportDb->FindReachableStops(_stopFrom, _maxTime);
+      vector<Json::Node> stops;
+      stops.reserve(reachableStops.size());
+      for (const auto &reachableStop : reachableStops)
+      {
+        stops.push_back(Json::Dict{
+            {"stop_name", Json::Node(_transportDb->GetRouter().GetStopName(reachableStop.stop_id))},
+            {"time", Json::Node(reachableStop.time)},
+        });
+      }
+      dict["stops"] = Json::Node(std::move(stops));
+#endif
+      return dict;
+    }
+
     Map::Map(Svg::MapVisualizerShp mapVisualizer) : _mapVisualizer(std::move(mapVisualizer))
     {
     }
@@ -244,7 +340,35 @@ namespace
       }
       else if (type == "Route")
       {
-        return Route(attrs.at("from").AsString(), attrs.at("to").AsString(), context);
+        optional<int> busWaitTime;
+        if (const auto *waitTimeNode = GetNodeByName(attrs, "bus_wait_time"))
+        {
+          busWaitTime = waitTimeNode->AsInt();
+        }
+        optional<double> busVelocity;
+        if (const auto *velocityNode = GetNodeByName(attrs, "bus_velocity"))
+        {
+          busVelocity = velocityNode->AsDouble();
+        }
+        return Route(attrs.at("from").AsString(), attrs.at("to").AsString(), context, busWaitTime, busVelocity);
+      }
+      else if (type == "RouteMatrix")
+      {
+        auto readStops = [](const Json::Node &stopsNode)
+        {
+          vector<string> stops;
+          stops.reserve(stopsNode.AsArray().size());
+          for (const auto &stopNode : stopsNode.AsArray())
+          {
+            stops.push_back(stopNode.AsString());
+          }
+          return stops;
+        };
+        return RouteMatrix(readStops(attrs.at("from")), readStops(attrs.at("to")), context->transportDb);
+      }
+      else if (type == "Reachable")
+      {
+        return Reachable(attrs.at("from").AsString(), attrs.at("max_time").AsDouble(), context->transportDb);
       }
       else if (type == "Map")
       {
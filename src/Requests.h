@@ -2,7 +2,9 @@
 
 #include <string>
 #include <variant>
+#include <vector>
 #include <memory>
+#include <optional>
 
 #include "Json.h"
 #include "YellowPages/YellowPagesDatabase.h"
@@ -51,9 +53,12 @@ namespace Requests
   class Route
   {
   public:
+    // Given bus_wait_time and bus_velocity override the routing settings for this request only
     Route(std::string stopFrom,
           std::string stopTo,
-          ContextShp context);
+          ContextShp context,
+          std::optional<int> busWaitTime = std::nullopt,
+          std::optional<double> busVelocity = std::nullopt);
 
     Json::Dict Process() const;
 
@@ -61,6 +66,38 @@ namespace Requests
     std::string _stopFrom;
     std::string _stopTo;
     ContextShp _context;
+    std::optional<int> _busWaitTime;
+    std::optional<double> _busVelocity;
+  };
+
+  // Total times between all pairs of stops, computed in one batch and without rendering
+  class RouteMatrix
+  {
+  public:
+    RouteMatrix(std::vector<std::string> stopsFrom,
+                std::vector<std::string> stopsTo,
+                TransportDatabaseShp transportDb);
+
+    Json::Dict Process() const;
+
+  private:
+    std::vector<std::string> _stopsFrom;
+    std::vector<std::string> _stopsTo;
+    TransportDatabaseShp _transportDb;
+  };
+
+  // Stops reachable from a stop within a time budget, with their earliest times
+  class Reachable
+  {
+  public:
+    Reachable(std::string stopFrom, double maxTime, TransportDatabaseShp transportDb);
+
+    Json::Dict Process() const;
+
+  private:
+    std::string _stopFrom;
+    double _maxTime;
+    TransportDatabaseShp _transportDb;
   };
 
   class Map
@@ -85,7 +122,7 @@ namespace Requests
     YellowPages::BLL::CompanyRestrictions _companyRestrictions;
   };
 
-  using Request = std::variant<Stop, Bus, Route, Map, FindCompanies>;
+  using Request = std::variant<Stop, Bus, Route, RouteMatrix, Reachable, Map, FindCompanies>;
   Request Read(const ContextShp &context, const Json::Dict &attrs);
 
   std::vector<Json::Node> ProcessAll(const ContextShp &context,
@@ -1,138 +1,262 @@
 #pragma once
 
 #include "Graph.h"
+#include "IRouter.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace Graph {
 
-  template <typename Weight>
-  class Router {
+  // All-pairs shortest paths precomputed by Floyd-Warshall: O(V^3) build, O(V^2) memory.
+  // StoredWeight may be narrower than Weight (e.g. float) to shrink the table. An integer
+  // StoredWeight keeps weights in fixed point units of 1 / StoredWeightScale: sums and
+  // compares are exact, so the table is the same on any compiler and architecture.
+  template <typename Weight, typename StoredWeight = Weight, int64_t StoredWeightScale = 1>
+  class Router : public IRouter<Weight> {
   private:
     using Graph = DirectedWeightedGraph<Weight>;
 
   public:
-    Router(const Graph& graph);
+    using CompactEdgeId = uint32_t;
+    static constexpr CompactEdgeId NoEdge = std::numeric_limits<CompactEdgeId>::max();
+    // Integer tables take half of the max: a sum of two stored weights never overflows,
+    // so a missing route never wins a compare
+    static constexpr StoredWeight NoRoute = std::is_integral_v<StoredWeight>
+        ? std::numeric_limits<StoredWeight>::max() / 2
+        : std::numeric_limits<StoredWeight>::infinity();
 
-    using RouteId = uint64_t;
-
-    struct RouteInfo {
-      RouteId id;
-      Weight weight;
-      size_t edge_count;
+    // Row-major vertex_count x vertex_count matrices.
+    // Missing routes have NoRoute weight; missing and empty routes have NoEdge prev edge.
+    struct RoutesInternalData {
+      size_t vertex_count = 0;
+      std::vector<StoredWeight> weights;
+      std::vector<CompactEdgeId> prev_edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
-    EdgeId GetRouteEdge(RouteId route_id, size_t edge_idx) const;
-    void ReleaseRoute(RouteId route_id);
+    // thread_count == 0 means hardware concurrency
+    Router(const Graph& graph, size_t thread_count = 1);
+    // Restores a router from a previously computed table
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
+
+    const RoutesInternalData& GetRoutesInternalData() const;
+
+    // Whether every route fits below NoRoute: a shortest route has no repeated edge, so its
+    // weight is at most the total of all edge weights. Narrower routes saturate to missing ones.
+    static bool CanStoreRoutes(const Graph& graph);
+
+  protected:
+    std::optional<Weight> ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const override;
 
   private:
     const Graph& graph_;
 
-    struct RouteInternalData {
-      Weight weight;
-      std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    static StoredWeight ToStoredWeight(Weight weight) {
+      if constexpr (std::is_integral_v<StoredWeight>) {
+        const auto stored_weight = std::llround(weight * StoredWeightScale);
+        assert(stored_weight < NoRoute);
+        return static_cast<StoredWeight>(std::min<long long>(stored_weight, NoRoute));
+      }
+      else {
+        return static_cast<StoredWeight>(weight);
+      }
+    }
+
+    static Weight ToWeight(StoredWeight stored_weight) {
+      if constexpr (std::is_integral_v<StoredWeight>) {
+        return static_cast<Weight>(stored_weight) / StoredWeightScale;
+      }
+      else {
+        return static_cast<Weight>(stored_weight);
+      }
+    }
 
-    using ExpandedRoute = std::vector<EdgeId>;
-    mutable RouteId next_route_id_ = 0;
-    mutable std::unordered_map<RouteId, ExpandedRoute> expanded_routes_cache_;
+    size_t GetCellIdx(VertexId from, VertexId to) const {
+      return from * routes_internal_data_.vertex_count + to;
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
       const size_t vertex_count = graph.GetVertexCount();
+      assert(graph.GetEdgeCount() < NoEdge);
+      routes_internal_data_.vertex_count = vertex_count;
+      routes_internal_data_.weights.assign(vertex_count * vertex_count, NoRoute);
+      routes_internal_data_.prev_edges.assign(vertex_count * vertex_count, NoEdge);
       for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-        routes_internal_data_[vertex][vertex] = RouteInternalData{0, std::nullopt};
-        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-          const auto& edge = graph.GetEdge(edge_id);
-          assert(edge.weight >= 0);
-          auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-          if (!route_internal_data || route_internal_data->weight > edge.weight) {
-            route_internal_data = RouteInternalData{edge.weight, edge_id};
+        routes_internal_data_.weights[GetCellIdx(vertex, vertex)] = 0;
+        for (const auto arc : graph.GetOutgoingArcs(vertex)) {
+          assert(arc.weight >= 0);
+          const size_t cell_idx = GetCellIdx(vertex, arc.to);
+          const StoredWeight edge_weight = ToStoredWeight(arc.weight);
+          if (routes_internal_data_.weights[cell_idx] > edge_weight) {
+            routes_internal_data_.weights[cell_idx] = edge_weight;
+            routes_internal_data_.prev_edges[cell_idx] = static_cast<CompactEdgeId>(arc.edge_id);
           }
         }
       }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to,
-                    const RouteInternalData& route_from, const RouteInternalData& route_to) {
-      auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-      const Weight candidate_weight = route_from.weight + route_to.weight;
-      if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-        route_relaxing = {
-            candidate_weight,
-            route_to.prev_edge
-                ? route_to.prev_edge
-                : route_from.prev_edge
-        };
+    // Min-plus kernel over one row. Rows don't alias and both rows are stored unconditionally
+    // as a select by the compare mask, so the loop has no control flow and compilers turn it
+    // into vector compares and blends even for baseline SSE2 (-fopt-info-vec reports it).
+    // Missing routes never win as NoRoute is infinite or sums with it saturate to NoRoute.
+    // An empty route to the vertex being relaxed through gives the current weight back,
+    // so its prev edge is never taken.
+    using MaskLane = std::conditional_t<sizeof(StoredWeight) == sizeof(uint64_t), uint64_t, uint32_t>;
+
+    static void RelaxRow(StoredWeight weight_from,
+                         const StoredWeight* __restrict weights_through,
+                         const CompactEdgeId* __restrict prev_edges_through,
+                         StoredWeight* __restrict weights_relaxing,
+                         CompactEdgeId* __restrict prev_edges_relaxing,
+                         size_t count) {
+      for (size_t idx = 0; idx < count; ++idx) {
+        StoredWeight candidate_weight = weight_from + weights_through[idx];
+        if constexpr (std::is_integral_v<StoredWeight>) {
+          // Two weights up to NoRoute sum without wrapping, saturating keeps every cell at most NoRoute
+          candidate_weight = candidate_weight < NoRoute ? candidate_weight : NoRoute;
+        }
+        const StoredWeight current_weight = weights_relaxing[idx];
+        // Prev edges are blended in lanes as wide as the weights, all ones when the candidate is shorter
+        const MaskLane candidate_prev_edge = prev_edges_through[idx];
+        const MaskLane current_prev_edge = prev_edges_relaxing[idx];
+        const MaskLane mask = MaskLane{0} - static_cast<MaskLane>(candidate_weight < current_weight);
+        weights_relaxing[idx] = candidate_weight < current_weight ? candidate_weight : current_weight;
+        prev_edges_relaxing[idx] = static_cast<CompactEdgeId>(current_prev_edge ^ ((current_prev_edge ^ candidate_prev_edge) & mask));
       }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-      for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-        if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-          for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-            if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-              RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-            }
+    struct TileRange {
+      VertexId begin;
+      VertexId end;
+    };
+
+    // Relaxes rows x columns tile through every vertex of the through range
+    void RelaxTile(TileRange rows, TileRange columns, TileRange through) {
+      auto& weights = routes_internal_data_.weights;
+      auto& prev_edges = routes_internal_data_.prev_edges;
+      for (VertexId vertex_through = through.begin; vertex_through < through.end; ++vertex_through) {
+        const size_t through_cell_idx = GetCellIdx(vertex_through, columns.begin);
+        for (VertexId vertex_from = rows.begin; vertex_from < rows.end; ++vertex_from) {
+          const StoredWeight weight_from = weights[GetCellIdx(vertex_from, vertex_through)];
+          // A row relaxed through its own vertex can't improve
+          if (weight_from == NoRoute || vertex_from == vertex_through) {
+            continue;
           }
+          const size_t relaxing_cell_idx = GetCellIdx(vertex_from, columns.begin);
+          RelaxRow(weight_from,
+                   &weights[through_cell_idx], &prev_edges[through_cell_idx],
+                   &weights[relaxing_cell_idx], &prev_edges[relaxing_cell_idx],
+                   columns.end - columns.begin);
         }
       }
     }
 
+    // Blocked Floyd-Warshall: for every diagonal tile the tile itself is relaxed first,
+    // then its row and column tiles, then all the rest. Tiles of one phase are independent
+    // and run in parallel, so the result does not depend on thread count.
+    void RelaxRoutesInternalData(size_t thread_count) {
+      const size_t vertex_count = routes_internal_data_.vertex_count;
+      const size_t tile_count = (vertex_count + TileSize - 1) / TileSize;
+      auto get_tile = [vertex_count](size_t tile_idx) {
+        return TileRange{tile_idx * TileSize, std::min(vertex_count, (tile_idx + 1) * TileSize)};
+      };
+
+      ThreadPool thread_pool(thread_count);
+      for (size_t diagonal_idx = 0; diagonal_idx < tile_count; ++diagonal_idx) {
+        const TileRange diagonal = get_tile(diagonal_idx);
+        RelaxTile(diagonal, diagonal, diagonal);
+
+        thread_pool.ParallelFor(2 * tile_count, [&](size_t task_idx) {
+          const size_t tile_idx = task_idx / 2;
+          if (tile_idx == diagonal_idx) {
+            return;
+          }
+          if (task_idx % 2 == 0) {
+            RelaxTile(diagonal, get_tile(tile_idx), diagonal);
+          }
+          else {
+            RelaxTile(get_tile(tile_idx), diagonal, diagonal);
+          }
+        });
+
+        thread_pool.ParallelFor(tile_count * tile_count, [&](size_t task_idx) {
+          const size_t row_idx = task_idx / tile_count;
+          const size_t column_idx = task_idx % tile_count;
+          if (row_idx == diagonal_idx || column_idx == diagonal_idx) {
+            return;
+          }
+          RelaxTile(get_tile(row_idx), get_tile(column_idx), diagonal);
+        });
+      }
+    }
+
+    // 128 x 128 tiles of weights and prev edges fit into L2 cache
+    static constexpr size_t TileSize = 128;
+
     RoutesInternalData routes_internal_data_;
   };
 
 
-  template <typename Weight>
-  Router<Weight>::Router(const Graph& graph)
-      : graph_(graph),
-        routes_internal_data_(graph.GetVertexCount(), std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+  template <typename Weight, typename StoredWeight, int64_t StoredWeightScale>
+  Router<Weight, StoredWeight, StoredWeightScale>::Router(const Graph& graph, size_t thread_count)
+      : graph_(graph)
   {
     InitializeRoutesInternalData(graph);
+    RelaxRoutesInternalData(thread_count);
+  }
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-      RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+  template <typename Weight, typename StoredWeight, int64_t StoredWeightScale>
+  Router<Weight, StoredWeight, StoredWeightScale>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+      : graph_(graph),
+        routes_internal_data_(std::move(routes_internal_data))
+  {
+    assert(routes_internal_data_.vertex_count == graph.GetVertexCount());
+    assert(routes_internal_data_.weights.size() == routes_internal_data_.vertex_count * routes_internal_data_.vertex_count);
+    assert(routes_internal_data_.prev_edges.size() == routes_internal_data_.weights.size());
+  }
+
+  template <typename Weight, typename StoredWeight, int64_t StoredWeightScale>
+  const typename Router<Weight, StoredWeight, StoredWeightScale>::RoutesInternalData& Router<Weight, StoredWeight, StoredWeightScale>::GetRoutesInternalData() const {
+    return routes_internal_data_;
+  }
+
+  template <typename Weight, typename StoredWeight, int64_t StoredWeightScale>
+  bool Router<Weight, StoredWeight, StoredWeightScale>::CanStoreRoutes(const Graph& graph) {
+    if constexpr (std::is_integral_v<StoredWeight>) {
+      long double total_weight = 0;
+      for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        total_weight += std::round(static_cast<long double>(graph.GetEdge(edge_id).weight) * StoredWeightScale);
+      }
+      return total_weight < NoRoute;
+    }
+    else {
+      return true;
     }
   }
 
-  template <typename Weight>
-  std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_[from][to];
-    if (!route_internal_data) {
+  template <typename Weight, typename StoredWeight, int64_t StoredWeightScale>
+  std::optional<Weight> Router<Weight, StoredWeight, StoredWeightScale>::ComputeRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const StoredWeight weight = routes_internal_data_.weights[GetCellIdx(from, to)];
+    if (weight == NoRoute) {
       return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-      edges.push_back(*edge_id);
+    edges.clear();
+    for (CompactEdgeId edge_id = routes_internal_data_.prev_edges[GetCellIdx(from, to)];
+         edge_id != NoEdge;
+         edge_id = routes_internal_data_.prev_edges[GetCellIdx(from, graph_.GetEdge(edge_id).from)]) {
+      edges.push_back(edge_id);
     }
     std::reverse(std::begin(edges), std::end(edges));
-
-    const RouteId route_id = next_route_id_++;
-    const size_t route_edge_count = edges.size();
-    expanded_routes_cache_[route_id] = std::move(edges);
-    return RouteInfo{route_id, weight, route_edge_count};
-  }
-
-  template <typename Weight>
-  EdgeId Router<Weight>::GetRouteEdge(RouteId route_id, size_t edge_idx) const {
-    return expanded_routes_cache_.at(route_id)[edge_idx];
-  }
-
-  template <typename Weight>
-  void Router<Weight>::ReleaseRoute(RouteId route_id) {
-    expanded_routes_cache_.erase(route_id);
+    return ToWeight(weight);
   }
 
-}
\ No newline at end of file
+}
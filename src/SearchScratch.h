@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Per vertex state of one search direction, reused across queries. Entries of a vertex are
+  // valid only if its stamp equals the current query's one, so a query only touches the
+  // vertices it reaches and nothing is cleared or allocated once the buffers have grown.
+  template <typename Weight>
+  struct SearchSide {
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    uint32_t stamp = 0;
+    std::vector<uint32_t> stamps;
+    std::vector<Weight> distances;
+    std::vector<EdgeId> parent_edges;  // edge or arc the vertex was reached by
+    std::vector<QueueItem> queue;  // min-heap
+
+    void StartQuery(size_t vertex_count) {
+      if (stamps.size() < vertex_count) {
+        stamps.resize(vertex_count, 0);
+        distances.resize(vertex_count);
+        parent_edges.resize(vertex_count);
+      }
+      queue.clear();
+      if (++stamp == 0) {
+        // Stamps wrapped around: forget every previous query
+        std::fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+      }
+    }
+
+    bool IsReached(VertexId vertex) const {
+      return stamps[vertex] == stamp;
+    }
+
+    void Reach(VertexId vertex, Weight distance, EdgeId parent_edge) {
+      Reach(vertex, distance, parent_edge, distance);
+    }
+
+    // Queues the vertex by a key other than its distance, e.g. an A* estimate
+    void Reach(VertexId vertex, Weight distance, EdgeId parent_edge, Weight key) {
+      stamps[vertex] = stamp;
+      distances[vertex] = distance;
+      parent_edges[vertex] = parent_edge;
+      queue.push_back({key, vertex});
+      std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+    }
+
+    QueueItem PopQueue() {
+      std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>());
+      const QueueItem item = queue.back();
+      queue.pop_back();
+      return item;
+    }
+  };
+
+  // Search sides of the thread, shared by all routers of the same weight type.
+  // Buffers grow to the largest graph searched on the thread.
+  template <typename Weight>
+  struct SearchScratch {
+    SearchSide<Weight> forward;
+    SearchSide<Weight> backward;
+
+    static SearchScratch& Get() {
+      static thread_local SearchScratch scratch;
+      return scratch;
+    }
+  };
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "DijkstraRouter.h"
+#include "Graph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+  // Least recently used complete shortest path trees by origin within a byte budget.
+  // A route from a cached origin is a walk along parent edges, a missing origin costs one
+  // full Dijkstra search. Trees are immutable and shared, so queries from many threads only
+  // lock to look them up.
+  template <typename Weight>
+  class ShortestPathTreeCache {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+  public:
+    struct Stats {
+      size_t hits = 0;
+      size_t misses = 0;
+    };
+
+    ShortestPathTreeCache(const Graph& graph, size_t byte_budget);
+
+    // Same as IRouter::FindRoute
+    std::optional<Weight> FindRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    Stats GetStats() const;
+    size_t GetTreeCapacity() const;
+
+  private:
+    using CompactEdgeId = uint32_t;
+    static constexpr CompactEdgeId NoEdge = std::numeric_limits<CompactEdgeId>::max();
+
+    struct Tree {
+      std::vector<Weight> distances;
+      std::vector<CompactEdgeId> parent_edges;  // NoEdge for the origin and unreachable vertices
+    };
+    using TreePtr = std::shared_ptr<const Tree>;
+
+    TreePtr GetTree(VertexId from) const;
+    TreePtr ComputeTree(VertexId from) const;
+
+    const Graph& graph_;
+    size_t tree_capacity_;
+
+    mutable std::mutex mutex_;
+    mutable std::list<std::pair<VertexId, TreePtr>> trees_;  // most recently used first
+    mutable std::unordered_map<VertexId, typename std::list<std::pair<VertexId, TreePtr>>::iterator> tree_its_;
+    mutable Stats stats_;
+  };
+
+
+  template <typename Weight>
+  ShortestPathTreeCache<Weight>::ShortestPathTreeCache(const Graph& graph, size_t byte_budget)
+      : graph_(graph),
+        tree_capacity_(byte_budget / std::max<size_t>(1, graph.GetVertexCount() * (sizeof(Weight) + sizeof(CompactEdgeId))))
+  {
+    assert(graph.GetEdgeCount() < NoEdge);
+  }
+
+  template <typename Weight>
+  std::optional<Weight> ShortestPathTreeCache<Weight>::FindRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const TreePtr tree = GetTree(from);
+    if (to != from && tree->parent_edges[to] == NoEdge) {
+      return std::nullopt;
+    }
+    edges.clear();
+    for (CompactEdgeId edge_id = tree->parent_edges[to]; edge_id != NoEdge;
+         edge_id = tree->parent_edges[graph_.GetEdge(edge_id).from]) {
+      edges.push_back(edge_id);
+    }
+    std::reverse(std::begin(edges), std::end(edges));
+    return tree->distances[to];
+  }
+
+  template <typename Weight>
+  typename ShortestPathTreeCache<Weight>::Stats ShortestPathTreeCache<Weight>::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+  }
+
+  template <typename Weight>
+  size_t ShortestPathTreeCache<Weight>::GetTreeCapacity() const {
+    return tree_capacity_;
+  }
+
+  template <typename Weight>
+  typename ShortestPathTreeCache<Weight>::TreePtr ShortestPathTreeCache<Weight>::GetTree(VertexId from) const {
+    {
+      std::lock_guard lock(mutex_);
+      if (const auto it = tree_its_.find(from); it != tree_its_.end()) {
+        ++stats_.hits;
+        trees_.splice(trees_.begin(), trees_, it->second);
+        return it->second->second;
+      }
+      ++stats_.misses;
+    }
+
+    // Searched without the lock, threads missing the same origin at once search it each
+    TreePtr tree = ComputeTree(from);
+    if (tree_capacity_ == 0) {
+      return tree;
+    }
+    std::lock_guard lock(mutex_);
+    if (tree_its_.count(from) == 0) {
+      if (trees_.size() == tree_capacity_) {
+        tree_its_.erase(trees_.back().first);
+        trees_.pop_back();
+      }
+      trees_.emplace_front(from, tree);
+      tree_its_.emplace(from, trees_.begin());
+    }
+    return tree;
+  }
+
+  template <typename Weight>
+  typename ShortestPathTreeCache<Weight>::TreePtr ShortestPathTreeCache<Weight>::ComputeTree(VertexId from) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const SearchSide<Weight>& search = ComputeShortestPathTree(graph_, from);
+    auto tree = std::make_shared<Tree>();
+    tree->distances.resize(vertex_count);
+    tree->parent_edges.assign(vertex_count, NoEdge);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+      if (search.IsReached(vertex)) {
+        tree->distances[vertex] = search.distances[vertex];
+        if (vertex != from) {
+          tree->parent_edges[vertex] = static_cast<CompactEdgeId>(search.parent_edges[vertex]);
+        }
+      }
+    }
+    return tree;
+  }
+
+}
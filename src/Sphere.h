@@ -3,6 +3,8 @@
 #include <cmath>
 
 namespace Sphere {
+  extern const double EARTH_RADIUS;  // in meters
+
   double ConvertDegreesToRadians(double degrees);
 
   struct Point {
@@ -45,12 +45,13 @@ void MapVisualizer::Render(std::ostream& out) const
     _mapDoc.Render(out);
 }
 
-void Svg::MapVisualizer::RenderRoute(std::ostream& out, const TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const
+void Svg::MapVisualizer::RenderRoute(std::ostream& out, const TransportRouter& router,
+    const TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const
 {
     RenderWholeMapIfNeeded();
     Document routeDoc = _mapDoc;
     RenderTranslucentRect(routeDoc);
-    auto route = MapRoute(routeInfo, finishStopName);
+    auto route = MapRoute(router, routeInfo, finishStopName);
 
     using RenderRouteLayerFunc = void (MapVisualizer::*)(Document&, const Route&) const;
     static const std::unordered_map<std::string, RenderRouteLayerFunc> layerNameToFunc = {
@@ -126,53 +127,38 @@ void MapVisualizer::RenderAllStopNames() const
     }
 }
 
-MapVisualizer::Route Svg::MapVisualizer::MapRoute(const TransportRouter::RouteInfo& routeInfo,
+MapVisualizer::Route Svg::MapVisualizer::MapRoute(const TransportRouter& router, const TransportRouter::RouteInfo& routeInfo,
     const std::string& finishStopName) const
 {
     Route route;
     route.reserve(routeInfo.items.size() / 2);
+    // A ride starts at the stop of the wait before it and ends at the stop of the next wait or at the finish
     std::string_view firstStopName;
-    const TransportRouter::RouteInfo::BusItem* busItem;
-    for (const auto& item : routeInfo.items)
+    for (size_t itemIdx = 0; itemIdx < routeInfo.items.size(); ++itemIdx)
     {
-        std::visit([this, &firstStopName, &busItem, &route](auto&& item)
-            {
-                using T = std::decay_t<decltype(item)>;
-                if constexpr (std::is_same_v<T, TransportRouter::RouteInfo::WaitItem>)
-                {
-                    const TransportRouter::RouteInfo::WaitItem& waitItem = item;
-                    if (!firstStopName.empty())
-                    {
-                        std::string_view lastStopName = waitItem.stop_name;
-                        route.emplace_back(MapRouteItem(busItem, firstStopName, lastStopName));
-                        firstStopName = lastStopName;
-                    }
-                    else
-                    {
-                        firstStopName = waitItem.stop_name;
-                    }
-                }
-                else if constexpr (std::is_same_v<T, TransportRouter::RouteInfo::BusItem>)
-                {
-                    busItem = &item;
-                }
-                else
-                {
-                    std::cerr << "Svg::MapVisualizer::MapRoute non-exhaustive visitor" << std::endl;
-                    // static_assert(false, "non-exhaustive visitor!");
-                }
-            }, item);
+        const auto& item = routeInfo.items[itemIdx];
+        if (const auto* waitItem = std::get_if<TransportRouter::RouteInfo::WaitItem>(&item))
+        {
+            firstStopName = router.GetStopName(waitItem->stop_id);
+            continue;
+        }
+        const auto& busItem = std::get<TransportRouter::RouteInfo::BusItem>(item);
+        std::string_view lastStopName = finishStopName;
+        if (itemIdx + 1 < routeInfo.items.size())
+        {
+            lastStopName = router.GetStopName(std::get<TransportRouter::RouteInfo::WaitItem>(routeInfo.items[itemIdx + 1]).stop_id);
+        }
+        route.emplace_back(MapRouteItem(router, &busItem, firstStopName, lastStopName));
     }
-    if (!firstStopName.empty())
-        route.emplace_back(MapRouteItem(busItem, firstStopName, finishStopName));
     return route;
 }
 
-MapVisualizer::RouteItem Svg::MapVisualizer::MapRouteItem(const TransportRouter::RouteInfo::BusItem* busItem,
+MapVisualizer::RouteItem Svg::MapVisualizer::MapRouteItem(const TransportRouter& router,
+    const TransportRouter::RouteInfo::BusItem* busItem,
     std::string_view firstStopName,
     std::string_view lastStopName) const
 {
-    const auto* bus = _buses.at(busItem->bus_name);
+    const auto* bus = _buses.at(router.GetBusName(busItem->bus_id));
     auto firstStopIt = std::find(cbegin(bus->stops), cend(bus->stops), firstStopName);
     while (true)
     {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <iostream>
 #include <map>
 #include <functional>
@@ -36,7 +37,9 @@ namespace Svg
             const Visualization::RenderSettings& renderSettins);
 
         void Render(std::ostream& out) const;
-        void RenderRoute(std::ostream& out, const Router::TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const;
+        // Names of route items are resolved by the router the route was found by
+        void RenderRoute(std::ostream& out, const Router::TransportRouter& router,
+            const Router::TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const;
 
     private:
         void RenderWholeMapIfNeeded() const;
@@ -47,8 +50,10 @@ namespace Svg
         void RenderAllStopPoints() const;
         void RenderAllStopNames() const;
 
-        Route MapRoute(const Router::TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const;
-        RouteItem MapRouteItem(const Router::TransportRouter::RouteInfo::BusItem* busItem,
+        Route MapRoute(const Router::TransportRouter& router,
+            const Router::TransportRouter::RouteInfo& routeInfo, const std::string& finishStopName) const;
+        RouteItem MapRouteItem(const Router::TransportRouter& router,
+            const Router::TransportRouter::RouteInfo::BusItem* busItem,
             std::string_view firstStopName,
             std::string_view lastStopName) const;
 
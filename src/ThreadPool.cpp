@@ -0,0 +1,87 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+  if (thread_count == 0) {
+    thread_count = max<size_t>(1, thread::hardware_concurrency());
+  }
+  workers_.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  tasks_ready_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+  return workers_.size() + 1;
+}
+
+void ThreadPool::ParallelFor(size_t task_count, const function<void(size_t)>& task)
+{
+  if (workers_.empty() || task_count <= 1) {
+    for (size_t task_idx = 0; task_idx < task_count; ++task_idx) {
+      task(task_idx);
+    }
+    return;
+  }
+
+  {
+    lock_guard lock(mutex_);
+    task_ = &task;
+    task_count_ = task_count;
+    next_task_ = 0;
+    busy_workers_ = workers_.size();
+    ++generation_;
+  }
+  tasks_ready_.notify_all();
+
+  RunTasks();
+
+  unique_lock lock(mutex_);
+  tasks_done_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+  uint64_t seen_generation = 0;
+  while (true) {
+    unique_lock lock(mutex_);
+    tasks_ready_.wait(lock, [this, seen_generation] { return stop_ || generation_ != seen_generation; });
+    if (stop_) {
+      return;
+    }
+    seen_generation = generation_;
+    lock.unlock();
+
+    RunTasks();
+
+    lock.lock();
+    if (--busy_workers_ == 0) {
+      tasks_done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks()
+{
+  for (size_t task_idx = next_task_++; task_idx < task_count_; task_idx = next_task_++) {
+    (*task_)(task_idx);
+  }
+}
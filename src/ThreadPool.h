@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers running index based parallel loops.
+// The calling thread takes part in ParallelFor as well.
+class ThreadPool {
+public:
+  // thread_count == 0 means hardware concurrency
+  explicit ThreadPool(size_t thread_count = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  size_t GetThreadCount() const;
+
+  // Runs task(i) for every i in [0, task_count) and waits for all of them
+  void ParallelFor(size_t task_count, const std::function<void(size_t)>& task);
+
+private:
+  void WorkerLoop();
+  void RunTasks();
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable tasks_ready_;
+  std::condition_variable tasks_done_;
+  const std::function<void(size_t)>* task_ = nullptr;
+  size_t task_count_ = 0;
+  std::atomic<size_t> next_task_ = 0;
+  size_t busy_workers_ = 0;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+};
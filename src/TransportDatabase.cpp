@@ -7,13 +7,14 @@ using namespace Router;
 
 TransportDatabase::TransportDatabase(Descriptions::InputQueries data,
     const Router::RoutingSettings& routingSettings,
-    const Visualization::RenderSettings& renderSettings) :
+    const Visualization::RenderSettings& renderSettings,
+    std::unique_ptr<Router::TransportRouter> router) :
     _busesDescr(std::move(data.buses)),
     _stopsDescr(std::move(data.stops)),
     _stops(),
     _buses(),
     _routingSettings(routingSettings),
-    _router(),
+    _router(std::move(router)),
     _renderSettings(renderSettings)
 {
     Descriptions::StopsDict stops_dict;
@@ -37,7 +38,9 @@ TransportDatabase::TransportDatabase(Descriptions::InputQueries data,
         }
     }
 
-    _router = make_unique<Router::TransportRouter>(stops_dict, buses_dict, _routingSettings);
+    if (!_router) {
+        _router = make_unique<Router::TransportRouter>(stops_dict, buses_dict, _routingSettings);
+    }
 }
 
 const TransportDatabase::Stop* TransportDatabase::GetStop(const string& name) const {
@@ -70,6 +73,24 @@ optional<TransportRouter::RouteInfo> TransportDatabase::FindRoute(const string&
     return _router->FindRoute(stopFrom, stopTo);
 }
 
+optional<TransportRouter::RouteInfo> TransportDatabase::FindRoute(const string& stopFrom, const string& stopTo,
+                                                                  const RoutingSettings& metric) const {
+    return _router->FindRoute(stopFrom, stopTo, metric);
+}
+
+void TransportDatabase::SelectRoutingEngine(size_t routeRequestCount) {
+    _router->SelectRoutingEngine(routeRequestCount);
+}
+
+vector<TransportRouter::ReachableStop> TransportDatabase::FindReachableStops(const string& stopFrom, double maxTime) const {
+    return _router->FindReachableStops(stopFrom, maxTime);
+}
+
+vector<vector<optional<double>>> TransportDatabase::ComputeRouteTimes(const vector<string>& stopsFrom,
+                                                                      const vector<string>& stopsTo) const {
+    return _router->ComputeRouteTimes(stopsFrom, stopsTo);
+}
+
 int TransportDatabase::ComputeRoadRouteLength(
     const vector<string>& stops,
     const Descriptions::StopsDict& stops_dict
@@ -94,6 +115,11 @@ double TransportDatabase::ComputeGeoRouteDistance(
     return result;
 }
 
+const Router::TransportRouter& TransportDatabase::GetRouter() const
+{
+    return *_router;
+}
+
 const Router::RoutingSettings& TransportDatabase::GetRoutingSettings() const
 {
     return _routingSettings;
@@ -38,9 +38,11 @@ private:
   using Stop = Responses::Stop;
 
 public:
+  // The router is built from descriptions unless a prebuilt one is passed
   TransportDatabase(Descriptions::InputQueries data,
                      const Router::RoutingSettings& routingSettings,
-                     const Visualization::RenderSettings& renderSettings);
+                     const Visualization::RenderSettings& renderSettings,
+                     std::unique_ptr<Router::TransportRouter> router = nullptr);
 
   TransportDatabase(const TransportDatabase& other) = delete;
   TransportDatabase& operator=(const TransportDatabase& other) = delete;
@@ -54,6 +56,14 @@ public:
   std::vector<const Descriptions::Stop*> GetStopsDescriptions() const;
 
   std::optional<Router::TransportRouter::RouteInfo> FindRoute(const std::string& stopFrom, const std::string& stopTo) const;
+  std::optional<Router::TransportRouter::RouteInfo> FindRoute(const std::string& stopFrom, const std::string& stopTo,
+                                                              const Router::RoutingSettings& metric) const;
+  std::vector<Router::TransportRouter::ReachableStop> FindReachableStops(const std::string& stopFrom, double maxTime) const;
+  std::vector<std::vector<std::optional<double>>> ComputeRouteTimes(const std::vector<std::string>& stopsFrom,
+                                                                   const std::vector<std::string>& stopsTo) const;
+  const Router::TransportRouter& GetRouter() const;
+  // Resolves the auto routing engine for the expected number of route requests
+  void SelectRoutingEngine(size_t routeRequestCount);
   const Router::RoutingSettings& GetRoutingSettings() const;
   const Visualization::RenderSettings& GetRenderSettings() const;
 
@@ -1,54 +1,780 @@
 #include "TransportRouter.h"
+#include "AStarRouter.h"
+#include "BidirectionalDijkstraRouter.h"
+#include "ContractionHierarchy.h"
+#include "DijkstraRouter.h"
+#include "HubLabelRouter.h"
+#include "LandmarkRouter.h"
+#include "RaptorRouter.h"
+#include "ReachabilityIndex.h"
+#include "Router.h"
+#include "ShortestPathTreeCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
 
 using namespace std;
 using namespace Router;
 
+RoutingEngine Router::NameToRoutingEngine(std::string_view name)
+{
+  if (name == "floyd_warshall") {
+    return RoutingEngine::FloydWarshall;
+  }
+  else if (name == "dijkstra") {
+    return RoutingEngine::Dijkstra;
+  }
+  else if (name == "contraction_hierarchy") {
+    return RoutingEngine::ContractionHierarchy;
+  }
+  else if (name == "raptor") {
+    return RoutingEngine::Raptor;
+  }
+  else if (name == "a_star") {
+    return RoutingEngine::AStar;
+  }
+  else if (name == "alt") {
+    return RoutingEngine::Alt;
+  }
+  else if (name == "bidirectional_dijkstra") {
+    return RoutingEngine::BidirectionalDijkstra;
+  }
+  else if (name == "hub_labels") {
+    return RoutingEngine::HubLabels;
+  }
+  else if (name == "auto") {
+    return RoutingEngine::Auto;
+  }
+  else {
+    std::cerr << __FILE__ << ' ' << __LINE__ << ": no RoutingEngine with name: " << name;
+    assert(false);
+  }
+  return RoutingEngine::FloydWarshall;
+}
+
+std::string_view Router::RoutingEngineToName(RoutingEngine engine)
+{
+  switch (engine) {
+  case RoutingEngine::FloydWarshall:
+    return "floyd_warshall";
+  case RoutingEngine::Dijkstra:
+    return "dijkstra";
+  case RoutingEngine::ContractionHierarchy:
+    return "contraction_hierarchy";
+  case RoutingEngine::Raptor:
+    return "raptor";
+  case RoutingEngine::AStar:
+    return "a_star";
+  case RoutingEngine::Alt:
+    return "alt";
+  case RoutingEngine::BidirectionalDijkstra:
+    return "bidirectional_dijkstra";
+  case RoutingEngine::HubLabels:
+    return "hub_labels";
+  case RoutingEngine::Auto:
+    return "auto";
+  }
+  return "";
+}
+
+RoutingEngine Router::SelectAutoRoutingEngine(size_t vertex_count, size_t edge_count, size_t route_count,
+                                              size_t memory_bytes, size_t table_cell_bytes)
+{
+  // Costs in units of one heap relaxation, constants fitted on a grid city of 784 stops:
+  // a search relaxes every edge and pops every vertex, a table cell update is about 3 times
+  // cheaper, a hierarchy takes about 6 searches per vertex to build and half a search per route
+  const double vertices = static_cast<double>(vertex_count);
+  const double search_cost = static_cast<double>(edge_count) + vertices * log2(max(vertices, 2.0));
+  const double routes = static_cast<double>(route_count);
+
+  const double searches_cost = routes * search_cost;
+  const double hierarchy_cost = 6 * vertices * search_cost + routes * search_cost / 2;
+  const double table_cost = vertices * vertices * vertices / 3;
+  const bool table_fits = memory_bytes == 0
+    || vertices * vertices * static_cast<double>(table_cell_bytes) <= static_cast<double>(memory_bytes);
+
+  // Ties go to the engine taking less memory
+  RoutingEngine engine = RoutingEngine::Dijkstra;
+  double cost = searches_cost;
+  if (hierarchy_cost < cost) {
+    engine = RoutingEngine::ContractionHierarchy;
+    cost = hierarchy_cost;
+  }
+  if (table_fits && table_cost < cost) {
+    engine = RoutingEngine::FloydWarshall;
+  }
+  return engine;
+}
+
+GraphModel Router::NameToGraphModel(std::string_view name)
+{
+  if (name == "stop_pairs") {
+    return GraphModel::StopPairs;
+  }
+  else if (name == "line_expanded") {
+    return GraphModel::LineExpanded;
+  }
+  else {
+    std::cerr << __FILE__ << ' ' << __LINE__ << ": no GraphModel with name: " << name;
+    assert(false);
+  }
+  return GraphModel::StopPairs;
+}
+
+LandmarkSelection Router::NameToLandmarkSelection(std::string_view name)
+{
+  if (name == "farthest") {
+    return LandmarkSelection::Farthest;
+  }
+  else if (name == "planar") {
+    return LandmarkSelection::Planar;
+  }
+  else {
+    std::cerr << __FILE__ << ' ' << __LINE__ << ": no LandmarkSelection with name: " << name;
+    assert(false);
+  }
+  return LandmarkSelection::Farthest;
+}
+
+StopOrder Router::NameToStopOrder(std::string_view name)
+{
+  if (name == "dict") {
+    return StopOrder::Dict;
+  }
+  else if (name == "bfs") {
+    return StopOrder::Bfs;
+  }
+  else if (name == "reverse_cuthill_mckee") {
+    return StopOrder::ReverseCuthillMcKee;
+  }
+  else if (name == "hilbert") {
+    return StopOrder::Hilbert;
+  }
+  else {
+    std::cerr << __FILE__ << ' ' << __LINE__ << ": no StopOrder with name: " << name;
+    assert(false);
+  }
+  return StopOrder::Dict;
+}
+
 RoutingSettings RoutingSettings::FromJson(const Json::Dict& json)
 {
-  return RoutingSettings{
+  RoutingSettings settings{
     json.at("bus_wait_time").AsInt(),
     json.at("bus_velocity").AsDouble(),
   };
+  if (const auto* engineNode = GetNodeByName(json, "routing_engine")) {
+    settings.routing_engine = NameToRoutingEngine(engineNode->AsString());
+  }
+  if (const auto* floatTableNode = GetNodeByName(json, "float_routes_table")) {
+    settings.float_routes_table = floatTableNode->AsBool();
+  }
+  if (const auto* fixedPointTableNode = GetNodeByName(json, "fixed_point_routes_table")) {
+    settings.fixed_point_routes_table = fixedPointTableNode->AsBool();
+  }
+  if (const auto* threadsNode = GetNodeByName(json, "routing_threads")) {
+    if (threadsNode->AsInt() >= 0) {
+      settings.routing_threads = threadsNode->AsInt();
+    }
+    else {
+      std::cerr << "negative routing_threads " << threadsNode->AsInt() << " rejected, using hardware concurrency" << std::endl;
+    }
+  }
+  if (const auto* graphModelNode = GetNodeByName(json, "graph_model")) {
+    settings.graph_model = NameToGraphModel(graphModelNode->AsString());
+  }
+  if (const auto* landmarkCountNode = GetNodeByName(json, "landmark_count")) {
+    if (landmarkCountNode->AsInt() >= 0) {
+      settings.landmark_count = landmarkCountNode->AsInt();
+    }
+    else {
+      std::cerr << "negative landmark_count " << landmarkCountNode->AsInt() << " rejected, using "
+                << settings.landmark_count << std::endl;
+    }
+  }
+  if (const auto* landmarkSelectionNode = GetNodeByName(json, "landmark_selection")) {
+    settings.landmark_selection = NameToLandmarkSelection(landmarkSelectionNode->AsString());
+  }
+  if (const auto* stopOrderNode = GetNodeByName(json, "stop_order")) {
+    settings.stop_order = NameToStopOrder(stopOrderNode->AsString());
+  }
+  if (const auto* routeCacheNode = GetNodeByName(json, "route_cache_bytes")) {
+    // Double for budgets beyond the int range
+    settings.route_cache_bytes = static_cast<size_t>(routeCacheNode->AsDouble());
+  }
+  if (const auto* memoryNode = GetNodeByName(json, "routing_memory_bytes")) {
+    settings.routing_memory_bytes = static_cast<size_t>(memoryNode->AsDouble());
+  }
+  return settings;
+}
+
+double RoutingSettings::ComputeRideTime(int distance) const
+{
+  return distance * 1.0 / (bus_velocity * 1000.0 / 60);  // m / (km/h * 1000 / 60) = min
+}
+
+size_t RoutingSettings::GetThreadCount() const
+{
+  return static_cast<size_t>(max(routing_threads, 0));
+}
+
+size_t RoutingSettings::GetLandmarkCount() const
+{
+  return static_cast<size_t>(max(landmark_count, 0));
+}
+
+bool RoutingSettings::HasValidMetric() const
+{
+  return bus_wait_time >= 0 && bus_velocity > 0 && isfinite(bus_velocity);
 }
 
 TransportRouter::TransportRouter(const Descriptions::StopsDict& stops_dict,
   const Descriptions::BusesDict& buses_dict,
   const RoutingSettings& routingSettings)
-  : routing_settings_(routingSettings)
+  : routing_settings_(routingSettings),
+    // Auto starts with the engine needing no preprocessing until SelectRoutingEngine
+    engine_(routingSettings.routing_engine == RoutingEngine::Auto ? RoutingEngine::Dijkstra : routingSettings.routing_engine)
 {
-  const size_t vertex_count = stops_dict.size() * 2;
-  vertices_info_.resize(vertex_count);
-  graph_ = BusGraph(vertex_count);
+  const size_t stop_vertex_count = stops_dict.size() * 2;
 
-  FillGraphWithStops(stops_dict);
-  FillGraphWithBuses(stops_dict, buses_dict);
+  if (routing_settings_.routing_engine == RoutingEngine::Raptor) {
+    graph_ = BusGraph(stop_vertex_count);
+    FillGraphWithStops(OrderStops(stops_dict, buses_dict));
+    FillBusLines(stops_dict, buses_dict);
+  }
+  else if (routing_settings_.graph_model == GraphModel::LineExpanded) {
+    size_t ride_vertex_count = 0;
+    for (const auto& [_, bus_item] : buses_dict) {
+      if (bus_item->stops.size() > 1) {
+        ride_vertex_count += bus_item->stops.size() - 1;
+      }
+    }
+    graph_ = BusGraph(stop_vertex_count + ride_vertex_count);
+    FillGraphWithStops(OrderStops(stops_dict, buses_dict));
+    FillBusLines(stops_dict, buses_dict);
+    FillGraphWithBusLines();
+  }
+  else {
+    graph_ = BusGraph(stop_vertex_count);
+    FillGraphWithStops(OrderStops(stops_dict, buses_dict));
+    FillGraphWithBuses(stops_dict, buses_dict);
+  }
+  graph_.Freeze();
+  BuildReachabilityIndex();
+  BuildRouter();
+  BuildRouteCache();
+}
+
+TransportRouter::TransportRouter(const RoutingSettings& routingSettings)
+  : routing_settings_(routingSettings),
+    engine_(routingSettings.routing_engine == RoutingEngine::Auto ? RoutingEngine::Dijkstra : routingSettings.routing_engine)
+{
+}
+
+TransportRouter::~TransportRouter() = default;
+
+void TransportRouter::BuildRouter() {
+  using FixedPointRouter = Graph::Router<double, uint32_t, FixedPointScale>;
+  switch (engine_) {
+  case RoutingEngine::FloydWarshall:
+    if (routing_settings_.fixed_point_routes_table && !FixedPointRouter::CanStoreRoutes(graph_)) {
+      std::cerr << "route times may not fit into fixed point milliseconds, using the double routes table" << std::endl;
+      routing_settings_.fixed_point_routes_table = false;
+    }
+    if (routing_settings_.fixed_point_routes_table) {
+      router_ = std::make_unique<FixedPointRouter>(graph_, routing_settings_.GetThreadCount());
+    }
+    else if (routing_settings_.float_routes_table) {
+      router_ = std::make_unique<Graph::Router<double, float>>(graph_, routing_settings_.GetThreadCount());
+    }
+    else {
+      router_ = std::make_unique<Graph::Router<double>>(graph_, routing_settings_.GetThreadCount());
+    }
+    break;
+  case RoutingEngine::Auto:  // never engine_
+  case RoutingEngine::Dijkstra:
+    router_ = std::make_unique<Graph::DijkstraRouter<double>>(graph_);
+    break;
+  case RoutingEngine::ContractionHierarchy:
+    router_ = std::make_unique<Graph::ContractionHierarchy<double>>(graph_);
+    break;
+  case RoutingEngine::Raptor:
+    raptor_router_ = std::make_unique<RaptorRouter>(stop_names_.size(), bus_lines_, routing_settings_);
+    break;
+  case RoutingEngine::AStar:
+    router_ = std::make_unique<Graph::AStarRouter<double>>(graph_, MakeGeoHeuristic());
+    break;
+  case RoutingEngine::BidirectionalDijkstra:
+    router_ = std::make_unique<Graph::BidirectionalDijkstraRouter<double>>(graph_);
+    break;
+  case RoutingEngine::HubLabels:
+    router_ = std::make_unique<Graph::HubLabelRouter<double>>(graph_);
+    break;
+  case RoutingEngine::Alt:
+    if (routing_settings_.landmark_selection == LandmarkSelection::Planar) {
+      router_ = std::make_unique<Graph::LandmarkRouter<double>>(graph_, SelectPlanarLandmarks());
+    }
+    else {
+      // Routes start and end at stop out vertices
+      vector<Graph::VertexId> candidates;
+      candidates.reserve(stop_names_.size());
+      for (Graph::VertexId vertex_id = 1; vertex_id < GetStopVertexCount(); vertex_id += 2) {
+        candidates.push_back(vertex_id);
+      }
+      router_ = std::make_unique<Graph::LandmarkRouter<double>>(graph_,
+        Graph::LandmarkRouter<double>::SelectFarthestLandmarks(graph_, candidates, routing_settings_.GetLandmarkCount()));
+    }
+    break;
+  }
+}
 
-  router_ = std::make_unique<Router>(graph_);
+void TransportRouter::BuildRouteCache() {
+  // Trees come from plain Dijkstra searches, other engines answer better from their own preprocessing
+  if (!router_ || engine_ != RoutingEngine::Dijkstra) {
+    return;
+  }
+  size_t cache_bytes = routing_settings_.route_cache_bytes;
+  if (cache_bytes == 0 && routing_settings_.routing_engine == RoutingEngine::Auto) {
+    // The auto engine spends its memory budget on the cache, the table it did not build would take more.
+    // Without a budget the cache takes up to 8 times the memory of the graph arcs.
+    constexpr size_t GraphMemoryMultiple = 8;
+    cache_bytes = routing_settings_.routing_memory_bytes > 0
+      ? routing_settings_.routing_memory_bytes
+      : GraphMemoryMultiple * graph_.GetEdgeCount() * sizeof(Graph::Arc<double>);
+  }
+  if (cache_bytes > 0) {
+    route_cache_ = std::make_unique<Graph::ShortestPathTreeCache<double>>(graph_, cache_bytes);
+    if (route_cache_->GetTreeCapacity() == 0) {
+      route_cache_.reset();  // not even one tree fits
+    }
+  }
 }
 
-void TransportRouter::FillGraphWithStops(const Descriptions::StopsDict& stops_dict) {
-  Graph::VertexId vertex_id = 0;
+void TransportRouter::BuildReachabilityIndex() {
+  // RAPTOR routes over bus lines, its graph has wait edges only
+  if (routing_settings_.routing_engine != RoutingEngine::Raptor) {
+    reachability_index_ = std::make_unique<Graph::ReachabilityIndex<double>>(graph_);
+  }
+}
 
-  for (const auto& [stop_name, _] : stops_dict) {
-    auto& vertex_ids = stops_vertex_ids_[stop_name];
-    vertex_ids.in = vertex_id++;
-    vertex_ids.out = vertex_id++;
-    vertices_info_[vertex_ids.in] = { stop_name };
-    vertices_info_[vertex_ids.out] = { stop_name };
+bool TransportRouter::MayReach(Graph::VertexId from, Graph::VertexId to) const {
+  return !reachability_index_ || reachability_index_->MayReach(from, to);
+}
+
+TransportRouter::RouteCacheStats TransportRouter::GetRouteCacheStats() const {
+  if (!route_cache_) {
+    return {};
+  }
+  const auto stats = route_cache_->GetStats();
+  return {.hits = stats.hits, .misses = stats.misses};
+}
+
+void TransportRouter::SelectRoutingEngine(size_t route_count) {
+  if (routing_settings_.routing_engine != RoutingEngine::Auto) {
+    return;
+  }
+  const size_t table_cell_bytes = routing_settings_.fixed_point_routes_table || routing_settings_.float_routes_table
+    ? sizeof(float) + sizeof(uint32_t)
+    : sizeof(double) + sizeof(uint32_t);
+  const RoutingEngine engine = SelectAutoRoutingEngine(graph_.GetVertexCount(), graph_.GetEdgeCount(), route_count,
+                                                       routing_settings_.routing_memory_bytes, table_cell_bytes);
+  std::cerr << "auto routing engine: " << RoutingEngineToName(engine) << " for " << route_count << " routes over "
+            << graph_.GetVertexCount() << " vertices and " << graph_.GetEdgeCount() << " edges, memory budget "
+            << routing_settings_.routing_memory_bytes << " bytes" << std::endl;
+  if (engine == engine_ && router_) {
+    return;
+  }
+  engine_ = engine;
+  route_cache_.reset();
+  router_.reset();  // before building the next one to not hold both
+  BuildRouter();
+  BuildRouteCache();
+}
+
+vector<Graph::VertexId> TransportRouter::SelectPlanarLandmarks() const {
+  // No more sectors than stops, like farthest landmarks are no more than candidates
+  const size_t sector_count = min(routing_settings_.GetLandmarkCount(), stop_positions_.size());
+  if (sector_count == 0) {
+    return {};
+  }
+  Sphere::Point center = { 0.0, 0.0 };
+  for (const auto& position : stop_positions_) {
+    center.latitude += position.latitude / stop_positions_.size();
+    center.longitude += position.longitude / stop_positions_.size();
+  }
+
+  // Stop farthest from the center in every sector, empty sectors give no landmark
+  vector<optional<size_t>> sector_stops(sector_count);
+  vector<double> sector_distances(sector_count, 0.0);
+  for (size_t stop_idx = 0; stop_idx < stop_positions_.size(); ++stop_idx) {
+    const auto& position = stop_positions_[stop_idx];
+    const double angle = atan2(position.latitude - center.latitude, position.longitude - center.longitude);
+    const size_t sector = min(sector_count - 1, static_cast<size_t>((angle + M_PI) / (2 * M_PI) * sector_count));
+    const double distance = Sphere::Distance(center, position);
+    if (!sector_stops[sector] || distance > sector_distances[sector]) {
+      sector_stops[sector] = stop_idx;
+      sector_distances[sector] = distance;
+    }
+  }
+
+  vector<Graph::VertexId> landmarks;
+  for (const auto& stop_idx : sector_stops) {
+    if (stop_idx) {
+      landmarks.push_back(2 * *stop_idx + 1);
+    }
+  }
+  return landmarks;
+}
+
+function<double(Graph::VertexId, Graph::VertexId)> TransportRouter::MakeGeoHeuristic() const {
+  // Chord between unit vectors times the radius is never longer than the great-circle distance
+  using UnitVector = array<double, 3>;
+  auto to_unit_vector = [](Sphere::Point position) {
+    const double latitude = Sphere::ConvertDegreesToRadians(position.latitude);
+    const double longitude = Sphere::ConvertDegreesToRadians(position.longitude);
+    return UnitVector{ cos(latitude) * cos(longitude), cos(latitude) * sin(longitude), sin(latitude) };
+  };
+  vector<UnitVector> vertex_vectors;
+  vertex_vectors.reserve(graph_.GetVertexCount());
+  for (Graph::VertexId vertex_id = 0; vertex_id < GetStopVertexCount(); ++vertex_id) {
+    vertex_vectors.push_back(to_unit_vector(stop_positions_[vertex_id / 2]));
+  }
+  if (graph_.GetVertexCount() > GetStopVertexCount()) {
+    // Line-expanded model: ride vertex of a line position is at its stop
+    for (const auto& bus_line : bus_lines_) {
+      for (size_t position = 1; position < bus_line.stops.size(); ++position) {
+        vertex_vectors.push_back(vertex_vectors[2 * bus_line.stops[position]]);
+      }
+    }
+  }
+  assert(vertex_vectors.size() == graph_.GetVertexCount());
+
+  auto chord = [](const UnitVector& lhs, const UnitVector& rhs) {
+    const double dx = lhs[0] - rhs[0], dy = lhs[1] - rhs[1], dz = lhs[2] - rhs[2];
+    return sqrt(dx * dx + dy * dy + dz * dz);
+  };
+
+  // A road shorter than the geo distance breaks the bound; scaling it down by the worst
+  // ratio keeps it admissible, down to plain Dijkstra when the ratio is 0
+  double minutes_per_chord = routing_settings_.ComputeRideTime(1) * Sphere::EARTH_RADIUS;
+  double scale = 1.0;
+  for (Graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+    const auto& edge = graph_.GetEdge(edge_id);
+    const double bound = minutes_per_chord * chord(vertex_vectors[edge.from], vertex_vectors[edge.to]);
+    if (bound > edge.weight) {
+      scale = min(scale, edge.weight / bound);
+    }
+  }
+  minutes_per_chord *= scale;
+
+  return [vertex_vectors = std::move(vertex_vectors), chord, minutes_per_chord](Graph::VertexId vertex, Graph::VertexId to) {
+    return minutes_per_chord * chord(vertex_vectors[vertex], vertex_vectors[to]);
+  };
+}
+
+static uint64_t ComputeHilbertIndex(uint32_t x, uint32_t y, uint32_t side) {
+  uint64_t index = 0;
+  for (uint32_t half = side / 2; half > 0; half /= 2) {
+    const uint32_t rx = (x & half) > 0;
+    const uint32_t ry = (y & half) > 0;
+    index += static_cast<uint64_t>(half) * half * ((3 * rx) ^ ry);
+    // Rotates the quadrant so that the curve continues from where it entered
+    if (ry == 0) {
+      if (rx == 1) {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      swap(x, y);
+    }
+  }
+  return index;
+}
+
+vector<const Descriptions::Stop*> TransportRouter::OrderStops(const Descriptions::StopsDict& stops_dict,
+                                                              const Descriptions::BusesDict& buses_dict) const {
+  vector<const Descriptions::Stop*> stops;
+  stops.reserve(stops_dict.size());
+  for (const auto& [_, stop] : stops_dict) {
+    stops.push_back(stop);
+  }
+  if (routing_settings_.stop_order == StopOrder::Dict) {
+    return stops;
+  }
+  sort(stops.begin(), stops.end(), [](const auto* lhs, const auto* rhs) { return lhs->name < rhs->name; });
+
+  if (routing_settings_.stop_order == StopOrder::Hilbert) {
+    double min_latitude = numeric_limits<double>::max(), max_latitude = numeric_limits<double>::lowest();
+    double min_longitude = numeric_limits<double>::max(), max_longitude = numeric_limits<double>::lowest();
+    for (const auto* stop : stops) {
+      min_latitude = min(min_latitude, stop->position.latitude);
+      max_latitude = max(max_latitude, stop->position.latitude);
+      min_longitude = min(min_longitude, stop->position.longitude);
+      max_longitude = max(max_longitude, stop->position.longitude);
+    }
+    constexpr uint32_t side = 1 << 16;
+    auto to_cell = [side](double value, double min_value, double max_value) {
+      return max_value > min_value ? static_cast<uint32_t>((value - min_value) / (max_value - min_value) * (side - 1)) : 0u;
+    };
+    vector<pair<uint64_t, const Descriptions::Stop*>> indexed_stops;
+    indexed_stops.reserve(stops.size());
+    for (const auto* stop : stops) {
+      indexed_stops.push_back({ComputeHilbertIndex(to_cell(stop->position.longitude, min_longitude, max_longitude),
+                                                   to_cell(stop->position.latitude, min_latitude, max_latitude), side),
+                               stop});
+    }
+    stable_sort(indexed_stops.begin(), indexed_stops.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    for (size_t idx = 0; idx < stops.size(); ++idx) {
+      stops[idx] = indexed_stops[idx].second;
+    }
+    return stops;
+  }
+
+  // Stops next to each other on some bus route are adjacent
+  unordered_map<string_view, size_t> stop_idxs;
+  for (size_t idx = 0; idx < stops.size(); ++idx) {
+    stop_idxs.emplace(stops[idx]->name, idx);
+  }
+  vector<vector<size_t>> adjacent_stops(stops.size());
+  for (const auto& [_, bus] : buses_dict) {
+    for (size_t stop_idx = 0; stop_idx + 1 < bus->stops.size(); ++stop_idx) {
+      const size_t lhs = stop_idxs.at(bus->stops[stop_idx]);
+      const size_t rhs = stop_idxs.at(bus->stops[stop_idx + 1]);
+      if (lhs != rhs) {
+        adjacent_stops[lhs].push_back(rhs);
+        adjacent_stops[rhs].push_back(lhs);
+      }
+    }
+  }
+  for (auto& adjacent : adjacent_stops) {
+    sort(adjacent.begin(), adjacent.end());
+    adjacent.erase(unique(adjacent.begin(), adjacent.end()), adjacent.end());
+  }
+
+  const bool is_cuthill_mckee = routing_settings_.stop_order == StopOrder::ReverseCuthillMcKee;
+  vector<size_t> roots(stops.size());
+  iota(roots.begin(), roots.end(), 0);
+  if (is_cuthill_mckee) {
+    auto by_degree = [&adjacent_stops](size_t lhs, size_t rhs) {
+      return adjacent_stops[lhs].size() < adjacent_stops[rhs].size();
+    };
+    stable_sort(roots.begin(), roots.end(), by_degree);
+    for (auto& adjacent : adjacent_stops) {
+      stable_sort(adjacent.begin(), adjacent.end(), by_degree);
+    }
+  }
+
+  // Breadth-first from every not yet visited root, so every component is covered
+  vector<size_t> order;
+  order.reserve(stops.size());
+  vector<bool> is_visited(stops.size(), false);
+  for (const size_t root : roots) {
+    if (is_visited[root]) {
+      continue;
+    }
+    is_visited[root] = true;
+    size_t queue_idx = order.size();
+    order.push_back(root);
+    for (; queue_idx < order.size(); ++queue_idx) {
+      for (const size_t adjacent : adjacent_stops[order[queue_idx]]) {
+        if (!is_visited[adjacent]) {
+          is_visited[adjacent] = true;
+          order.push_back(adjacent);
+        }
+      }
+    }
+  }
+  if (is_cuthill_mckee) {
+    reverse(order.begin(), order.end());
+  }
+
+  vector<const Descriptions::Stop*> ordered_stops;
+  ordered_stops.reserve(stops.size());
+  for (const size_t idx : order) {
+    ordered_stops.push_back(stops[idx]);
+  }
+  return ordered_stops;
+}
+
+void TransportRouter::FillGraphWithStops(const vector<const Descriptions::Stop*>& stops) {
+  // Reserved up front: stop_ids_ keys view the names in place
+  stop_names_.reserve(stops.size());
+  for (const auto* stop : stops) {
+    const uint32_t stop_id = stop_names_.size();
+    stop_ids_.emplace(stop_names_.emplace_back(stop->name), stop_id);
+    if (routing_settings_.routing_engine == RoutingEngine::AStar || routing_settings_.routing_engine == RoutingEngine::Alt) {
+      stop_positions_.push_back(stop->position);
+    }
 
     edges_info_.push_back(WaitEdgeInfo{});
-    const Graph::EdgeId edge_id = graph_.AddEdge({
-        vertex_ids.out,
-        vertex_ids.in,
+    edge_distances_.push_back(0);
+    [[maybe_unused]] const Graph::EdgeId edge_id = graph_.AddEdge({
+        2 * stop_id + 1,
+        2 * stop_id,
         static_cast<double>(routing_settings_.bus_wait_time)
       });
     assert(edge_id == edges_info_.size() - 1);
   }
 
-  assert(vertex_id == graph_.GetVertexCount());
+  assert(GetStopVertexCount() <= graph_.GetVertexCount());
+}
+
+uint32_t TransportRouter::GetStopId(const string& stop_name) const {
+  return stop_ids_.at(stop_name);
+}
+
+size_t TransportRouter::GetStopVertexCount() const {
+  return 2 * stop_names_.size();
+}
+
+const string& TransportRouter::GetStopName(uint32_t stop_id) const {
+  return stop_names_[stop_id];
+}
+
+const string& TransportRouter::GetBusName(uint32_t bus_id) const {
+  return bus_names_[bus_id];
 }
 
 void TransportRouter::FillGraphWithBuses(const Descriptions::StopsDict& stops_dict,
+  const Descriptions::BusesDict& buses_dict) {
+  // Buses riding the same stop sequence share a pattern expanded once, by its first bus
+  struct RoutePattern {
+    const Descriptions::Bus* bus;
+    vector<uint32_t> bus_ids;
+    vector<uint32_t> stop_ids;
+    vector<int> distances;  // from the first stop
+  };
+  vector<RoutePattern> patterns;
+  map<vector<uint32_t>, size_t> pattern_idxs;  // by stop ids
+  for (const auto& [_, bus_item] : buses_dict) {
+    const auto& bus = *bus_item;
+    if (bus.stops.size() <= 1) {
+      continue;
+    }
+    const uint32_t bus_id = bus_names_.size();
+    bus_names_.push_back(bus.name);
+    vector<uint32_t> stop_ids;
+    stop_ids.reserve(bus.stops.size());
+    for (const auto& stop_name : bus.stops) {
+      stop_ids.push_back(GetStopId(stop_name));
+    }
+    const auto [it, is_inserted] = pattern_idxs.emplace(stop_ids, patterns.size());
+    if (is_inserted) {
+      patterns.push_back({ &bus, {}, std::move(stop_ids), {} });
+    }
+    patterns[it->second].bus_ids.push_back(bus_id);
+  }
+
+  ThreadPool thread_pool(routing_settings_.GetThreadCount());
+  thread_pool.ParallelFor(patterns.size(), [&](size_t pattern_idx) {
+    RoutePattern& pattern = patterns[pattern_idx];
+    const auto& stops = pattern.bus->stops;
+    pattern.distances.reserve(stops.size());
+    pattern.distances.push_back(0);
+    for (size_t stop_idx = 1; stop_idx < stops.size(); ++stop_idx) {
+      pattern.distances.push_back(pattern.distances.back() +
+        Descriptions::ComputeStopsDistance(*stops_dict.at(stops[stop_idx - 1]), *stops_dict.at(stops[stop_idx])));
+    }
+  });
+
+  // Of parallel rides only the shortest one gets an edge: longer ones are never on a shortest route.
+  // Buses riding it as long and over as many stops are recorded as equivalent to the kept one.
+  struct BusRide {
+    Graph::VertexId from;
+    Graph::VertexId to;
+    int distance;
+    uint32_t bus_id;
+    size_t span_count;
+    vector<uint32_t> equivalent_bus_ids;
+    // Where the ride was met first, edges are added in this order as if rides were collected sequentially
+    size_t pattern_idx;
+    size_t start_stop_idx;
+    size_t finish_stop_idx;
+  };
+  // Rides are collected by shards of their start stops, each shard walks the patterns in order
+  const size_t shard_count = 4 * thread_pool.GetThreadCount();
+  vector<vector<BusRide>> shard_rides(shard_count);
+  thread_pool.ParallelFor(shard_count, [&](size_t shard) {
+    vector<BusRide>& rides = shard_rides[shard];
+    unordered_map<uint64_t, size_t> ride_idxs;  // by from and to vertices
+    for (size_t pattern_idx = 0; pattern_idx < patterns.size(); ++pattern_idx) {
+      const RoutePattern& pattern = patterns[pattern_idx];
+      const size_t stop_count = pattern.stop_ids.size();
+      const uint32_t bus_id = pattern.bus_ids.front();
+      auto add_equivalent_buses = [&pattern](BusRide& ride) {
+        for (const uint32_t member_id : pattern.bus_ids) {
+          if (member_id != ride.bus_id
+              && find(ride.equivalent_bus_ids.begin(), ride.equivalent_bus_ids.end(), member_id) == ride.equivalent_bus_ids.end()) {
+            ride.equivalent_bus_ids.push_back(member_id);
+          }
+        }
+      };
+      for (size_t start_stop_idx = 0; start_stop_idx + 1 < stop_count; ++start_stop_idx) {
+        if (pattern.stop_ids[start_stop_idx] % shard_count != shard) {
+          continue;
+        }
+        const Graph::VertexId start_vertex = 2 * pattern.stop_ids[start_stop_idx];
+        for (size_t finish_stop_idx = start_stop_idx + 1; finish_stop_idx < stop_count; ++finish_stop_idx) {
+          const int total_distance = pattern.distances[finish_stop_idx] - pattern.distances[start_stop_idx];
+          const Graph::VertexId finish_vertex = 2 * pattern.stop_ids[finish_stop_idx] + 1;
+          const size_t span_count = finish_stop_idx - start_stop_idx;
+          const auto [it, is_inserted] = ride_idxs.emplace(static_cast<uint64_t>(start_vertex) << 32 | finish_vertex, rides.size());
+          if (is_inserted) {
+            add_equivalent_buses(rides.emplace_back(BusRide{ start_vertex, finish_vertex, total_distance, bus_id, span_count, {},
+                                                             pattern_idx, start_stop_idx, finish_stop_idx }));
+            continue;
+          }
+          BusRide& ride = rides[it->second];
+          if (total_distance < ride.distance) {
+            ride.distance = total_distance;
+            ride.bus_id = bus_id;
+            ride.span_count = span_count;
+            ride.equivalent_bus_ids.clear();
+            add_equivalent_buses(ride);
+          }
+          else if (total_distance == ride.distance && span_count == ride.span_count) {
+            add_equivalent_buses(ride);
+          }
+        }
+      }
+    }
+  });
+
+  vector<BusRide> rides;
+  for (auto& shard : shard_rides) {
+    move(shard.begin(), shard.end(), back_inserter(rides));
+  }
+  sort(rides.begin(), rides.end(), [](const BusRide& lhs, const BusRide& rhs) {
+    return tie(lhs.pattern_idx, lhs.start_stop_idx, lhs.finish_stop_idx)
+      < tie(rhs.pattern_idx, rhs.start_stop_idx, rhs.finish_stop_idx);
+  });
+
+  for (auto& ride : rides) {
+    // In bus order as if every bus were expanded on its own
+    sort(ride.equivalent_bus_ids.begin(), ride.equivalent_bus_ids.end());
+    edges_info_.push_back(BusEdgeInfo{
+        .bus_id = ride.bus_id,
+        .span_count = ride.span_count,
+        .equivalent_buses_begin = static_cast<uint32_t>(equivalent_bus_ids_.size()),
+        .equivalent_bus_count = static_cast<uint32_t>(ride.equivalent_bus_ids.size()),
+      });
+    equivalent_bus_ids_.insert(equivalent_bus_ids_.end(), ride.equivalent_bus_ids.begin(), ride.equivalent_bus_ids.end());
+    edge_distances_.push_back(ride.distance);
+    [[maybe_unused]] const Graph::EdgeId edge_id = graph_.AddEdge({ ride.from, ride.to, routing_settings_.ComputeRideTime(ride.distance) });
+    assert(edge_id == edges_info_.size() - 1);
+  }
+}
+
+void TransportRouter::FillBusLines(const Descriptions::StopsDict& stops_dict,
   const Descriptions::BusesDict& buses_dict) {
   for (const auto& [_, bus_item] : buses_dict) {
     const auto& bus = *bus_item;
@@ -56,64 +782,260 @@ void TransportRouter::FillGraphWithBuses(const Descriptions::StopsDict& stops_di
     if (stop_count <= 1) {
       continue;
     }
-    auto compute_distance_from = [&stops_dict, &bus](size_t lhs_idx) {
-      return Descriptions::ComputeStopsDistance(*stops_dict.at(bus.stops[lhs_idx]), *stops_dict.at(bus.stops[lhs_idx + 1]));
-      };
-    for (size_t start_stop_idx = 0; start_stop_idx + 1 < stop_count; ++start_stop_idx) {
-      const Graph::VertexId start_vertex = stops_vertex_ids_[bus.stops[start_stop_idx]].in;
-      int total_distance = 0;
-      for (size_t finish_stop_idx = start_stop_idx + 1; finish_stop_idx < stop_count; ++finish_stop_idx) {
-        total_distance += compute_distance_from(finish_stop_idx - 1);
-        edges_info_.push_back(BusEdgeInfo{
-            .bus_name = bus.name,
-            .span_count = finish_stop_idx - start_stop_idx,
-          });
-        const Graph::EdgeId edge_id = graph_.AddEdge({
-            start_vertex,
-            stops_vertex_ids_[bus.stops[finish_stop_idx]].out,
-            total_distance * 1.0 / (routing_settings_.bus_velocity * 1000.0 / 60)  // m / (km/h * 1000 / 60) = min
-          });
-        assert(edge_id == edges_info_.size() - 1);
+
+    BusLine& bus_line = bus_lines_.emplace_back(BusLine{ .bus_id = static_cast<uint32_t>(bus_names_.size()), .stops = {}, .distances = {} });
+    bus_names_.push_back(bus.name);
+    bus_line.stops.reserve(stop_count);
+    bus_line.distances.reserve(stop_count);
+    for (size_t stop_idx = 0; stop_idx < stop_count; ++stop_idx) {
+      bus_line.stops.push_back(GetStopId(bus.stops[stop_idx]));
+      bus_line.distances.push_back(stop_idx == 0 ? 0 : bus_line.distances.back() +
+        Descriptions::ComputeStopsDistance(*stops_dict.at(bus.stops[stop_idx - 1]), *stops_dict.at(bus.stops[stop_idx])));
+    }
+  }
+}
+
+void TransportRouter::FillGraphWithBusLines() {
+  // Ride vertices follow stop vertices, line by line
+  Graph::VertexId first_ride_vertex = GetStopVertexCount();
+  auto add_edge = [this](const Graph::Edge<double>& edge, int distance, EdgeInfo edge_info) {
+    edges_info_.push_back(std::move(edge_info));
+    edge_distances_.push_back(distance);
+    [[maybe_unused]] const Graph::EdgeId edge_id = graph_.AddEdge(edge);
+    assert(edge_id == edges_info_.size() - 1);
+  };
+
+  for (size_t line_idx = 0; line_idx < bus_lines_.size(); ++line_idx) {
+    const BusLine& bus_line = bus_lines_[line_idx];
+    const size_t stop_count = bus_line.stops.size();
+    // Position 0 has no ride vertex: the bus is boarded there, never alighted
+    auto get_ride_vertex = [first_ride_vertex](size_t position) {
+      return first_ride_vertex + position - 1;
+    };
+    for (size_t position = 0; position + 1 < stop_count; ++position) {
+      const int hop_distance = bus_line.distances[position + 1] - bus_line.distances[position];
+      const double hop_time = routing_settings_.ComputeRideTime(hop_distance);
+      add_edge({ 2 * bus_line.stops[position], get_ride_vertex(position + 1), hop_time }, hop_distance,
+               BoardEdgeInfo{ .line_idx = line_idx, .position = position });
+      if (position > 0) {
+        add_edge({ get_ride_vertex(position), get_ride_vertex(position + 1), hop_time }, hop_distance, HopEdgeInfo{});
       }
     }
+    for (size_t position = 1; position < stop_count; ++position) {
+      add_edge({ get_ride_vertex(position), 2 * bus_line.stops[position] + 1, 0.0 }, 0,
+               AlightEdgeInfo{ .line_idx = line_idx, .position = position });
+    }
+    first_ride_vertex += stop_count - 1;
   }
+
+  assert(first_ride_vertex == graph_.GetVertexCount());
 }
 
-optional<TransportRouter::RouteInfo> TransportRouter::FindRoute(const string& stopFrom, const string& stopTo) const {
-  const Graph::VertexId vertex_from = stops_vertex_ids_.at(stopFrom).out;
-  const Graph::VertexId vertex_to = stops_vertex_ids_.at(stopTo).out;
-  const auto route = router_->BuildRoute(vertex_from, vertex_to);
-  if (!route) {
+double TransportRouter::ComputeEdgeWeight(Graph::EdgeId edge_id, const RoutingSettings& metric) const {
+  if (holds_alternative<WaitEdgeInfo>(edges_info_[edge_id])) {
+    return static_cast<double>(metric.bus_wait_time);
+  }
+  return metric.ComputeRideTime(edge_distances_[edge_id]);
+}
+
+TransportRouter::RouteInfo::BusItem TransportRouter::MakeLineBusItem(size_t line_idx,
+  size_t board_position, size_t alight_position, const RoutingSettings& metric) const {
+  const BusLine& bus_line = bus_lines_[line_idx];
+  return RouteInfo::BusItem{
+      .bus_id = bus_line.bus_id,
+      .time = metric.ComputeRideTime(bus_line.distances[alight_position] - bus_line.distances[board_position]),
+      .span_count = alight_position - board_position,
+    };
+}
+
+optional<TransportRouter::RouteInfo> TransportRouter::FindRaptorRoute(const string& stopFrom, const string& stopTo,
+  const RoutingSettings& metric) const {
+  const auto journey = raptor_router_->FindJourney(GetStopId(stopFrom), GetStopId(stopTo), metric);
+  if (!journey) {
     return nullopt;
   }
 
-  RouteInfo route_info = { .total_time = route->weight };
-  route_info.items.reserve(route->edge_count);
-  for (size_t edge_idx = 0; edge_idx < route->edge_count; ++edge_idx) {
-    const Graph::EdgeId edge_id = router_->GetRouteEdge(route->id, edge_idx);
-    const auto& edge = graph_.GetEdge(edge_id);
+  RouteInfo route_info = { .total_time = journey->total_time, .items = {} };
+  route_info.items.reserve(journey->rides.size() * 2);
+  for (const auto& ride : journey->rides) {
+    route_info.items.push_back(RouteInfo::WaitItem{
+        .stop_id = bus_lines_[ride.line_idx].stops[ride.board_position],
+        .time = static_cast<double>(metric.bus_wait_time),
+      });
+    route_info.items.push_back(MakeLineBusItem(ride.line_idx, ride.board_position, ride.alight_position, metric));
+  }
+  return route_info;
+}
+
+TransportRouter::RouteInfo TransportRouter::MakeRouteInfo(double total_time, const vector<Graph::EdgeId>& edges,
+  const RoutingSettings& metric) const {
+  RouteInfo route_info = { .total_time = total_time, .items = {} };
+  route_info.items.reserve(edges.size());
+  const BoardEdgeInfo* board_edge_info = nullptr;
+  for (const Graph::EdgeId edge_id : edges) {
     const auto& edge_info = edges_info_[edge_id];
     if (holds_alternative<BusEdgeInfo>(edge_info)) {
       const BusEdgeInfo& bus_edge_info = get<BusEdgeInfo>(edge_info);
       route_info.items.push_back(RouteInfo::BusItem{
-          .bus_name = bus_edge_info.bus_name,
-          .time = edge.weight,
+          .bus_id = bus_edge_info.bus_id,
+          .time = ComputeEdgeWeight(edge_id, metric),
           .span_count = bus_edge_info.span_count,
+          .equivalent_bus_ids = {
+            equivalent_bus_ids_.data() + bus_edge_info.equivalent_buses_begin,
+            equivalent_bus_ids_.data() + bus_edge_info.equivalent_buses_begin + bus_edge_info.equivalent_bus_count,
+          },
         });
     }
-    else {
-      const Graph::VertexId vertex_id = edge.from;
+    else if (holds_alternative<WaitEdgeInfo>(edge_info)) {
       route_info.items.push_back(RouteInfo::WaitItem{
-          .stop_name = vertices_info_[vertex_id].stop_name,
-          .time = edge.weight,
+          .stop_id = static_cast<uint32_t>(graph_.GetEdge(edge_id).from / 2),
+          .time = ComputeEdgeWeight(edge_id, metric),
         });
     }
+    else if (holds_alternative<BoardEdgeInfo>(edge_info)) {
+      board_edge_info = &get<BoardEdgeInfo>(edge_info);
+    }
+    else if (holds_alternative<AlightEdgeInfo>(edge_info)) {
+      // Hops between boarding and alighting collapse into a single ride, like a stop pairs edge
+      const AlightEdgeInfo& alight_edge_info = get<AlightEdgeInfo>(edge_info);
+      assert(board_edge_info && board_edge_info->line_idx == alight_edge_info.line_idx);
+      route_info.items.push_back(MakeLineBusItem(alight_edge_info.line_idx, board_edge_info->position,
+                                                 alight_edge_info.position, metric));
+      board_edge_info = nullptr;
+    }
   }
 
-  // Releasing in destructor of some proxy object would be better,
-  // but we do not expect exceptions in normal workflow
-  router_->ReleaseRoute(route->id);
+  if (routing_settings_.graph_model == GraphModel::LineExpanded ||
+      routing_settings_.fixed_point_routes_table || routing_settings_.float_routes_table) {
+    // Hop weights and weights stored in a compact table sum up with a different rounding than
+    // the exact item times
+    route_info.total_time = 0;
+    for (const auto& item : route_info.items) {
+      route_info.total_time += visit([](const auto& typed_item) { return typed_item.time; }, item);
+    }
+  }
   return route_info;
 }
 
+optional<TransportRouter::RouteInfo> TransportRouter::FindRoute(const string& stopFrom, const string& stopTo) const {
+  if (raptor_router_) {
+    return FindRaptorRoute(stopFrom, stopTo, routing_settings_);
+  }
+
+  // Edges buffer of the thread keeps its capacity, so routers allocate nothing for the path
+  static thread_local vector<Graph::EdgeId> edges;
+  const Graph::VertexId from = 2 * GetStopId(stopFrom) + 1;
+  const Graph::VertexId to = 2 * GetStopId(stopTo) + 1;
+  if (!MayReach(from, to)) {
+    return nullopt;
+  }
+  const auto total_time = route_cache_ ? route_cache_->FindRoute(from, to, edges) : router_->FindRoute(from, to, edges);
+  if (!total_time) {
+    return nullopt;
+  }
+  return MakeRouteInfo(*total_time, edges, routing_settings_);
+}
 
+optional<TransportRouter::RouteInfo> TransportRouter::FindRoute(const string& stopFrom, const string& stopTo,
+  const RoutingSettings& metric) const {
+  if (metric.bus_wait_time == routing_settings_.bus_wait_time && metric.bus_velocity == routing_settings_.bus_velocity) {
+    return FindRoute(stopFrom, stopTo);
+  }
+  // Infinite or negative edge weights break the search
+  if (!metric.HasValidMetric()) {
+    return nullopt;
+  }
+  if (raptor_router_) {
+    return FindRaptorRoute(stopFrom, stopTo, metric);
+  }
+
+  // The topology stays, weights of the relaxed edges are derived from their distances for the metric
+  static thread_local vector<Graph::EdgeId> edges;
+  const Graph::VertexId from = 2 * GetStopId(stopFrom) + 1;
+  const Graph::VertexId to = 2 * GetStopId(stopTo) + 1;
+  if (!MayReach(from, to)) {
+    return nullopt;
+  }
+  const auto total_time = Graph::ComputeShortestPath(graph_, from, to,
+    [this, &metric](const Graph::Arc<double>& arc) { return ComputeEdgeWeight(arc.edge_id, metric); }, edges);
+  if (!total_time) {
+    return nullopt;
+  }
+  return MakeRouteInfo(*total_time, edges, metric);
+}
+
+vector<vector<optional<double>>> TransportRouter::ComputeRouteTimes(const vector<string>& stopsFrom,
+  const vector<string>& stopsTo) const {
+  vector<vector<optional<double>>> times(stopsFrom.size(), vector<optional<double>>(stopsTo.size()));
+  // Names come from requests: unknown stops are left out and give not found rows and columns
+  struct KnownStop {
+    size_t idx;  // in the request
+    uint32_t stop_id;
+  };
+  auto get_known_stops = [this](const vector<string>& stops) {
+    vector<KnownStop> known_stops;
+    known_stops.reserve(stops.size());
+    for (size_t idx = 0; idx < stops.size(); ++idx) {
+      if (const auto it = stop_ids_.find(stops[idx]); it != stop_ids_.end()) {
+        known_stops.push_back({ idx, it->second });
+      }
+    }
+    return known_stops;
+  };
+  const auto known_from = get_known_stops(stopsFrom);
+  const auto known_to = get_known_stops(stopsTo);
+
+  if (raptor_router_) {
+    for (const auto& from : known_from) {
+      const auto arrival_times = raptor_router_->ComputeArrivalTimes(from.stop_id);
+      for (const auto& to : known_to) {
+        const double time = arrival_times[to.stop_id];
+        if (time != numeric_limits<double>::infinity()) {
+          times[from.idx][to.idx] = time;
+        }
+      }
+    }
+    return times;
+  }
+
+  auto get_vertices = [](const vector<KnownStop>& stops) {
+    vector<Graph::VertexId> vertices;
+    vertices.reserve(stops.size());
+    for (const auto& stop : stops) {
+      vertices.push_back(2 * stop.stop_id + 1);
+    }
+    return vertices;
+  };
+  const auto weights = router_->BuildWeightsTable(get_vertices(known_from), get_vertices(known_to));
+  for (size_t from_idx = 0; from_idx < known_from.size(); ++from_idx) {
+    for (size_t to_idx = 0; to_idx < known_to.size(); ++to_idx) {
+      times[known_from[from_idx].idx][known_to[to_idx].idx] = weights[from_idx * known_to.size() + to_idx];
+    }
+  }
+  return times;
+}
+
+vector<TransportRouter::ReachableStop> TransportRouter::FindReachableStops(const string& stopFrom, double maxTime) const {
+  vector<ReachableStop> reachable_stops;
+  if (raptor_router_) {
+    // RAPTOR graph has no bus edges, rounds give arrivals at every stop
+    const auto arrival_times = raptor_router_->ComputeArrivalTimes(GetStopId(stopFrom));
+    for (size_t stop_idx = 0; stop_idx < arrival_times.size(); ++stop_idx) {
+      if (arrival_times[stop_idx] <= maxTime) {
+        reachable_stops.push_back({ static_cast<uint32_t>(stop_idx), arrival_times[stop_idx] });
+      }
+    }
+    sort(reachable_stops.begin(), reachable_stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+      return lhs.time < rhs.time;
+    });
+    return reachable_stops;
+  }
+
+  // Routes end at stop out vertices, settling order is the time order
+  for (const auto& [vertex_id, time] : Graph::ComputeWeightsWithin(graph_, 2 * GetStopId(stopFrom) + 1, maxTime)) {
+    if (vertex_id < GetStopVertexCount() && vertex_id % 2 == 1) {
+      reachable_stops.push_back({ static_cast<uint32_t>(vertex_id / 2), time });
+    }
+  }
+  return reachable_stops;
+}
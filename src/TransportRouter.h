@@ -3,41 +3,135 @@
 #include "Descriptions.h"
 #include "Graph.h"
 #include "Json.h"
-#include "Router.h"
+#include "IRouter.h"
+#include "Sphere.h"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+namespace Serialization
+{
+  class TransportCatalogProtoMapper;
+}
+
+namespace Graph
+{
+  template <typename Weight>
+  class ShortestPathTreeCache;
+  template <typename Weight>
+  class ReachabilityIndex;
+}
+
 namespace Router
 {
+  enum class RoutingEngine {
+    FloydWarshall,  // all pairs table built on load
+    Dijkstra,  // search per query
+    ContractionHierarchy,  // shortcuts built with the base, bidirectional search per query
+    Raptor,  // rounds over bus stop sequences per query, no graph
+    AStar,  // search per query directed by the geo distance to the target
+    Alt,  // search per query directed by distances to landmarks built with the base
+    BidirectionalDijkstra,  // searches from both ends per query in reused per-thread buffers
+    HubLabels,  // labels built with the base answer RouteMatrix by merges, Route runs a Dijkstra search
+    Auto,  // one of the above chosen on load by the graph size, memory budget and expected route count
+  };
+
+  RoutingEngine NameToRoutingEngine(std::string_view name);
+  std::string_view RoutingEngineToName(RoutingEngine engine);
+
+  enum class GraphModel {
+    StopPairs,  // edge from every stop to every later stop of a bus, O(L^2) per bus
+    LineExpanded,  // vertex per stop of a bus and edge per hop, O(L) per bus
+  };
+
+  GraphModel NameToGraphModel(std::string_view name);
+
+  enum class LandmarkSelection {
+    Farthest,  // every next landmark is the stop farthest by route time from the selected ones
+    Planar,  // the stop farthest from the center in each of equal angular sectors
+  };
+
+  LandmarkSelection NameToLandmarkSelection(std::string_view name);
+
+  // Order of stop ids, and so of their vertices, for memory locality of searches and tables
+  enum class StopOrder {
+    Dict,  // iteration order of the stops dict
+    Bfs,  // breadth-first over stops adjacent on bus routes
+    ReverseCuthillMcKee,  // breadth-first from a low degree stop by increasing degree, reversed
+    Hilbert,  // along the Hilbert curve over stop positions
+  };
+
+  StopOrder NameToStopOrder(std::string_view name);
+
   struct RoutingSettings {
     int bus_wait_time;  // in minutes
     double bus_velocity;  // km/h
+    RoutingEngine routing_engine = RoutingEngine::FloydWarshall;
+    bool float_routes_table = false;  // 8 instead of 12 bytes per Floyd-Warshall cell at the cost of precision
+    bool fixed_point_routes_table = false;  // 8 instead of 12 bytes per Floyd-Warshall cell, weights in rounded milliseconds
+    int routing_threads = 0;  // threads building the routing graph and tables, 0 means hardware concurrency
+    GraphModel graph_model = GraphModel::StopPairs;
+    int landmark_count = 8;  // ALT engine only
+    LandmarkSelection landmark_selection = LandmarkSelection::Farthest;
+    StopOrder stop_order = StopOrder::Dict;
+    size_t route_cache_bytes = 0;  // shortest path trees by origin for the Dijkstra engine, 0 disables
+    size_t routing_memory_bytes = 0;  // budget of routing tables for the auto engine, 0 means no limit
   
     static RoutingSettings FromJson(const Json::Dict& json);
+
+    double ComputeRideTime(int distance) const;  // in minutes
+    // routing_threads for a thread pool, negative counts mean hardware concurrency like 0
+    size_t GetThreadCount() const;
+    // landmark_count for landmark selection, negative counts give no landmarks
+    size_t GetLandmarkCount() const;
+
+    // Non negative wait and positive finite velocity, so every edge weight is finite and non negative
+    bool HasValidMetric() const;
   };
 
+  // Engine the auto one resolves to: the one with the least estimated time to build and answer
+  // route_count routes among a Dijkstra search per route, a contraction hierarchy and a
+  // Floyd-Warshall table of table_cell_bytes per vertex pair if it fits into memory_bytes
+  RoutingEngine SelectAutoRoutingEngine(size_t vertex_count, size_t edge_count, size_t route_count,
+                                        size_t memory_bytes, size_t table_cell_bytes);
+
+  // Stops of a bus in riding order
+  struct BusLine {
+    uint32_t bus_id;  // index in the bus names of the router
+    std::vector<uint32_t> stops;  // stop i owns vertices 2 * i (in) and 2 * i + 1 (out)
+    std::vector<int> distances;  // from the first stop of the line
+  };
+
+  class RaptorRouter;
+
   class TransportRouter {
   private:
     using BusGraph = Graph::DirectedWeightedGraph<double>;
-    using Router = Graph::Router<double>;
+    using Router = Graph::IRouter<double>;
   
   public:
     TransportRouter(const Descriptions::StopsDict& stops_dict,
                     const Descriptions::BusesDict& buses_dict,
                     const RoutingSettings& routingSettings);
+    ~TransportRouter();
   
+    // Stops and buses are referred to by ids, GetStopName and GetBusName give their names
     struct RouteInfo {
       double total_time;
   
       struct BusItem {
-        std::string bus_name;
+        uint32_t bus_id;
         double time;
         size_t span_count;
+        // Other buses riding between the same stops as long, stop pairs graph model only
+        Range<const uint32_t*> equivalent_bus_ids = { nullptr, nullptr };
       };
       struct WaitItem {
-        std::string stop_name;
+        uint32_t stop_id;
         double time;
       };
   
@@ -46,33 +140,127 @@ namespace Router
     };
   
     std::optional<RouteInfo> FindRoute(const std::string& stopFrom, const std::string& stopTo) const;
+    // Route for bus_wait_time and bus_velocity of metric instead of the ones the router was built with:
+    // edge weights are derived from the stored distances, precomputed tables are not used.
+    // A metric without HasValidMetric gives no route.
+    std::optional<RouteInfo> FindRoute(const std::string& stopFrom, const std::string& stopTo,
+                                       const RoutingSettings& metric) const;
+
+    struct ReachableStop {
+      uint32_t stop_id;
+      double time;
+    };
+    // Stops reachable from stopFrom within maxTime, stopFrom included, by increasing time
+    std::vector<ReachableStop> FindReachableStops(const std::string& stopFrom, double maxTime) const;
+
+    // Total times of routes from every stop of stopsFrom to every stop of stopsTo, nullopt for missing routes
+    std::vector<std::vector<std::optional<double>>> ComputeRouteTimes(const std::vector<std::string>& stopsFrom,
+                                                                     const std::vector<std::string>& stopsTo) const;
+
+    const std::string& GetStopName(uint32_t stop_id) const;
+    const std::string& GetBusName(uint32_t bus_id) const;
+
+    // Shortest path trees cache of the route_cache_bytes routing setting
+    struct RouteCacheStats {
+      size_t hits = 0;
+      size_t misses = 0;
+    };
+    RouteCacheStats GetRouteCacheStats() const;
+
+    // Auto engine only: rebuilds the router for the engine of SelectAutoRoutingEngine when it
+    // differs from the current one, the choice is logged to stderr
+    void SelectRoutingEngine(size_t route_count);
+
+    // Units of the fixed point routes table per minute of route time
+    static constexpr int64_t FixedPointScale = 60'000;
   
   private:
-    void FillGraphWithStops(const Descriptions::StopsDict& stops_dict);
+    // Precomputed graph and tables are restored from the serialized base
+    friend class Serialization::TransportCatalogProtoMapper;
+    explicit TransportRouter(const RoutingSettings& routingSettings);
+
+    // Stops in the order of routing_settings_.stop_order, ties broken by name
+    std::vector<const Descriptions::Stop*> OrderStops(const Descriptions::StopsDict& stops_dict,
+                                                      const Descriptions::BusesDict& buses_dict) const;
+
+    void FillGraphWithStops(const std::vector<const Descriptions::Stop*>& stops);
+
+    // Stop i owns vertices 2 * i (in) and 2 * i + 1 (out)
+    uint32_t GetStopId(const std::string& stop_name) const;
+    size_t GetStopVertexCount() const;
   
     void FillGraphWithBuses(const Descriptions::StopsDict& stops_dict,
                             const Descriptions::BusesDict& buses_dict);
-  
-    struct StopVertexIds {
-      Graph::VertexId in;
-      Graph::VertexId out;
-    };
-    struct VertexInfo {
-      std::string stop_name;
-    };
+
+    void FillBusLines(const Descriptions::StopsDict& stops_dict,
+                      const Descriptions::BusesDict& buses_dict);
+
+    void FillGraphWithBusLines();
+
+    void BuildRouter();
+
+    // Search engines only, after the router is built or restored
+    void BuildRouteCache();
+
+    // Graph engines only, after the graph is built or restored
+    void BuildReachabilityIndex();
+
+    // False when the index tells there is no route between the stops
+    bool MayReach(Graph::VertexId from, Graph::VertexId to) const;
+
+    // Lower bound of the ride time by the geo distance, scaled down if some road is shorter than it
+    std::function<double(Graph::VertexId, Graph::VertexId)> MakeGeoHeuristic() const;
+
+    std::vector<Graph::VertexId> SelectPlanarLandmarks() const;
+
+    // Weight of the edge for the metric, the graph weight for the router's own settings
+    double ComputeEdgeWeight(Graph::EdgeId edge_id, const RoutingSettings& metric) const;
+
+    RouteInfo::BusItem MakeLineBusItem(size_t line_idx, size_t board_position, size_t alight_position,
+                                       const RoutingSettings& metric) const;
+
+    RouteInfo MakeRouteInfo(double total_time, const std::vector<Graph::EdgeId>& edges,
+                            const RoutingSettings& metric) const;
+
+    std::optional<RouteInfo> FindRaptorRoute(const std::string& stopFrom, const std::string& stopTo,
+                                             const RoutingSettings& metric) const;
   
     struct BusEdgeInfo {
-      std::string bus_name;
+      uint32_t bus_id;
       size_t span_count;
+      // In equivalent_bus_ids_
+      uint32_t equivalent_buses_begin = 0;
+      uint32_t equivalent_bus_count = 0;
     };
     struct WaitEdgeInfo {};
-    using EdgeInfo = std::variant<BusEdgeInfo, WaitEdgeInfo>;
+
+    // Line-expanded model: stop.in -> board -> ride vertex -> hop ... -> alight -> stop.out
+    struct BoardEdgeInfo {
+      size_t line_idx;
+      size_t position;
+    };
+    struct HopEdgeInfo {};
+    struct AlightEdgeInfo {
+      size_t line_idx;
+      size_t position;
+    };
+    using EdgeInfo = std::variant<BusEdgeInfo, WaitEdgeInfo, BoardEdgeInfo, HopEdgeInfo, AlightEdgeInfo>;
   
     RoutingSettings routing_settings_;
+    RoutingEngine engine_;  // of router_, never Auto
     BusGraph graph_;
     std::unique_ptr<Router> router_;
-    std::unordered_map<std::string, StopVertexIds> stops_vertex_ids_;
-    std::vector<VertexInfo> vertices_info_;
+    std::unique_ptr<RaptorRouter> raptor_router_;  // replaces router_ for the RAPTOR engine
+    std::unique_ptr<Graph::ShortestPathTreeCache<double>> route_cache_;  // answers routes instead of router_
+    std::unique_ptr<Graph::ReachabilityIndex<double>> reachability_index_;  // rejects unreachable routes before router_
+    // Interned names: routes, edges and lines refer to stops and buses by their index here
+    std::vector<std::string> stop_names_;
+    std::vector<std::string> bus_names_;
+    std::unordered_map<std::string_view, uint32_t> stop_ids_;  // views of stop_names_
     std::vector<EdgeInfo> edges_info_;
+    std::vector<int> edge_distances_;  // ridden meters, 0 for wait and alight edges
+    std::vector<uint32_t> equivalent_bus_ids_;  // of bus edges back to back
+    std::vector<BusLine> bus_lines_;  // line-expanded model and RAPTOR engine only
+    std::vector<Sphere::Point> stop_positions_;  // of stop i, A* and ALT engines only
   };
 }
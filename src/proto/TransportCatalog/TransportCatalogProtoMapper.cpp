@@ -5,9 +5,129 @@
 #include "RenderSettings.h"
 #include "Svg/Rgb.h"
 #include "Svg/Rgba.h"
+#include "Router.h"
+#include "ContractionHierarchy.h"
+#include "HubLabelRouter.h"
+#include "LandmarkRouter.h"
+
+#include <cassert>
+#include <unordered_map>
 
 using namespace Serialization;
 
+namespace
+{
+    template <typename RoutesInternalData, typename PbWeights>
+    void MapRoutesTable(const RoutesInternalData& table, PbWeights& pbWeights, Serialization::RoutesTable& pbTable)
+    {
+        pbWeights.Reserve(table.weights.size());
+        pbTable.mutable_prev_edges()->Reserve(table.prev_edges.size());
+        for (const auto weight : table.weights)
+        {
+            pbWeights.Add(weight);
+        }
+        for (const auto prevEdge : table.prev_edges)
+        {
+            pbTable.add_prev_edges(prevEdge + 1);
+        }
+    }
+
+    template <typename FloydWarshallRouter, typename PbWeights>
+    typename FloydWarshallRouter::RoutesInternalData MapRoutesTable(const PbWeights& pbWeights,
+                                                                    const Serialization::RoutesTable& pbTable,
+                                                                    size_t vertexCount)
+    {
+        assert(static_cast<size_t>(pbWeights.size()) == vertexCount * vertexCount);
+        assert(pbTable.prev_edges_size() == pbWeights.size());
+        typename FloydWarshallRouter::RoutesInternalData table;
+        table.vertex_count = vertexCount;
+        table.weights.assign(pbWeights.begin(), pbWeights.end());
+        table.prev_edges.reserve(pbTable.prev_edges_size());
+        for (const auto prevEdge : pbTable.prev_edges())
+        {
+            table.prev_edges.push_back(prevEdge - 1);
+        }
+        return table;
+    }
+
+    using ContractionHierarchyRouter = Graph::ContractionHierarchy<double>;
+
+    void MapContractionHierarchy(const ContractionHierarchyRouter::HierarchyData& hierarchy,
+                                 Serialization::ContractionHierarchy& pbHierarchy)
+    {
+        pbHierarchy.mutable_ranks()->Add(hierarchy.ranks.begin(), hierarchy.ranks.end());
+        for (const auto& shortcut : hierarchy.shortcuts)
+        {
+            pbHierarchy.add_shortcut_from(shortcut.from);
+            pbHierarchy.add_shortcut_to(shortcut.to);
+            pbHierarchy.add_shortcut_weight(shortcut.weight);
+            pbHierarchy.add_shortcut_first_arc(shortcut.first_arc);
+            pbHierarchy.add_shortcut_second_arc(shortcut.second_arc);
+        }
+    }
+
+    ContractionHierarchyRouter::HierarchyData MapContractionHierarchy(const Serialization::ContractionHierarchy& pbHierarchy)
+    {
+        ContractionHierarchyRouter::HierarchyData hierarchy;
+        hierarchy.ranks.assign(pbHierarchy.ranks().begin(), pbHierarchy.ranks().end());
+        hierarchy.shortcuts.reserve(pbHierarchy.shortcut_from_size());
+        for (int shortcutIdx = 0; shortcutIdx < pbHierarchy.shortcut_from_size(); ++shortcutIdx)
+        {
+            hierarchy.shortcuts.push_back({
+                pbHierarchy.shortcut_from(shortcutIdx),
+                pbHierarchy.shortcut_to(shortcutIdx),
+                pbHierarchy.shortcut_weight(shortcutIdx),
+                pbHierarchy.shortcut_first_arc(shortcutIdx),
+                pbHierarchy.shortcut_second_arc(shortcutIdx) });
+        }
+        return hierarchy;
+    }
+
+    using LandmarkRouter = Graph::LandmarkRouter<double>;
+
+    void MapLandmarks(const LandmarkRouter::LandmarksData& landmarks, Serialization::Landmarks& pbLandmarks)
+    {
+        pbLandmarks.mutable_vertices()->Add(landmarks.landmarks.begin(), landmarks.landmarks.end());
+        pbLandmarks.mutable_from_distances()->Add(landmarks.from_landmarks.begin(), landmarks.from_landmarks.end());
+        pbLandmarks.mutable_to_distances()->Add(landmarks.to_landmarks.begin(), landmarks.to_landmarks.end());
+    }
+
+    LandmarkRouter::LandmarksData MapLandmarks(const Serialization::Landmarks& pbLandmarks)
+    {
+        return LandmarkRouter::LandmarksData{
+            .landmarks = { pbLandmarks.vertices().begin(), pbLandmarks.vertices().end() },
+            .from_landmarks = { pbLandmarks.from_distances().begin(), pbLandmarks.from_distances().end() },
+            .to_landmarks = { pbLandmarks.to_distances().begin(), pbLandmarks.to_distances().end() } };
+    }
+
+    using HubLabelRouter = Graph::HubLabelRouter<double>;
+
+    using FixedPointFloydWarshallRouter = Graph::Router<double, uint32_t, Router::TransportRouter::FixedPointScale>;
+
+    void MapHubLabels(const HubLabelRouter::LabelsData& labels, Serialization::HubLabels& pbLabels)
+    {
+        pbLabels.mutable_out_label_begins()->Add(labels.out_labels.label_begins.begin(), labels.out_labels.label_begins.end());
+        pbLabels.mutable_out_hubs()->Add(labels.out_labels.hubs.begin(), labels.out_labels.hubs.end());
+        pbLabels.mutable_out_distances()->Add(labels.out_labels.distances.begin(), labels.out_labels.distances.end());
+        pbLabels.mutable_in_label_begins()->Add(labels.in_labels.label_begins.begin(), labels.in_labels.label_begins.end());
+        pbLabels.mutable_in_hubs()->Add(labels.in_labels.hubs.begin(), labels.in_labels.hubs.end());
+        pbLabels.mutable_in_distances()->Add(labels.in_labels.distances.begin(), labels.in_labels.distances.end());
+    }
+
+    HubLabelRouter::LabelsData MapHubLabels(const Serialization::HubLabels& pbLabels)
+    {
+        return HubLabelRouter::LabelsData{
+            .out_labels = {
+                .label_begins = { pbLabels.out_label_begins().begin(), pbLabels.out_label_begins().end() },
+                .hubs = { pbLabels.out_hubs().begin(), pbLabels.out_hubs().end() },
+                .distances = { pbLabels.out_distances().begin(), pbLabels.out_distances().end() } },
+            .in_labels = {
+                .label_begins = { pbLabels.in_label_begins().begin(), pbLabels.in_label_begins().end() },
+                .hubs = { pbLabels.in_hubs().begin(), pbLabels.in_hubs().end() },
+                .distances = { pbLabels.in_distances().begin(), pbLabels.in_distances().end() } } };
+    }
+}
+
 TransportCatalog Serialization::TransportCatalogProtoMapper::Map(const TransportDatabase& db)
 {
     auto pbBuses = Map(db.GetBusesDescriptions());
@@ -23,6 +143,7 @@ TransportCatalog Serialization::TransportCatalogProtoMapper::Map(const Transport
     }
     *catalog.mutable_routing_settings() = Map(db.GetRoutingSettings());
     *catalog.mutable_render_settings() = Map(db.GetRenderSettings());
+    *catalog.mutable_router() = Map(db.GetRouter());
     return catalog;
 }
 
@@ -40,10 +161,13 @@ TransportDatabase Serialization::TransportCatalogProtoMapper::Map(const Transpor
     {
         stops.emplace_back(Map(pbStop));
     }
+    const auto routingSettings = Map(catalog.routing_settings());
+    auto router = catalog.has_router() ? Map(catalog.router(), routingSettings) : nullptr;
     return TransportDatabase(
         Descriptions::InputQueries{ .buses = std::move(buses), .stops = std::move(stops) },
-        Map(catalog.routing_settings()),
-        Map(catalog.render_settings())
+        routingSettings,
+        Map(catalog.render_settings()),
+        std::move(router)
     );
 }
 
@@ -167,6 +291,16 @@ Serialization::RoutingSettings Serialization::TransportCatalogProtoMapper::Map(c
     Serialization::RoutingSettings pbSettings;
     pbSettings.set_bus_wait_time(settings.bus_wait_time);
     pbSettings.set_bus_velocity(settings.bus_velocity);
+    pbSettings.set_routing_engine(static_cast<Serialization::RoutingSettings_RoutingEngine>(settings.routing_engine));
+    pbSettings.set_float_routes_table(settings.float_routes_table);
+    pbSettings.set_fixed_point_routes_table(settings.fixed_point_routes_table);
+    pbSettings.set_routing_threads(settings.routing_threads);
+    pbSettings.set_graph_model(static_cast<Serialization::RoutingSettings_GraphModel>(settings.graph_model));
+    pbSettings.set_landmark_count(settings.landmark_count);
+    pbSettings.set_landmark_selection(static_cast<Serialization::RoutingSettings_LandmarkSelection>(settings.landmark_selection));
+    pbSettings.set_stop_order(static_cast<Serialization::RoutingSettings_StopOrder>(settings.stop_order));
+    pbSettings.set_route_cache_bytes(settings.route_cache_bytes);
+    pbSettings.set_routing_memory_bytes(settings.routing_memory_bytes);
     return pbSettings;
 }
 
@@ -174,10 +308,238 @@ Router::RoutingSettings Serialization::TransportCatalogProtoMapper::Map(const Se
 {
     return Router::RoutingSettings{
         .bus_wait_time = pbSettings.bus_wait_time(),
-        .bus_velocity = pbSettings.bus_velocity()
+        .bus_velocity = pbSettings.bus_velocity(),
+        .routing_engine = static_cast<Router::RoutingEngine>(pbSettings.routing_engine()),
+        .float_routes_table = pbSettings.float_routes_table(),
+        .fixed_point_routes_table = pbSettings.fixed_point_routes_table(),
+        .routing_threads = pbSettings.routing_threads(),
+        .graph_model = static_cast<Router::GraphModel>(pbSettings.graph_model()),
+        .landmark_count = pbSettings.landmark_count(),
+        .landmark_selection = static_cast<Router::LandmarkSelection>(pbSettings.landmark_selection()),
+        .stop_order = static_cast<Router::StopOrder>(pbSettings.stop_order()),
+        .route_cache_bytes = pbSettings.route_cache_bytes(),
+        .routing_memory_bytes = pbSettings.routing_memory_bytes()
     };
 }
 
+Serialization::TransportRouter Serialization::TransportCatalogProtoMapper::Map(const Router::TransportRouter& router)
+{
+    using TransportRouter = Router::TransportRouter;
+    Serialization::TransportRouter pbRouter;
+
+    pbRouter.mutable_stop_names()->Add(router.stop_names_.begin(), router.stop_names_.end());
+    pbRouter.set_vertex_count(router.graph_.GetVertexCount());
+    if (router.routing_settings_.routing_engine == Router::RoutingEngine::AStar)
+    {
+        for (const auto& position : router.stop_positions_)
+        {
+            *pbRouter.add_stop_positions() = Map(position);
+        }
+    }
+
+    pbRouter.mutable_bus_names()->Add(router.bus_names_.begin(), router.bus_names_.end());
+    for (const auto& busLine : router.bus_lines_)
+    {
+        auto& pbLine = *pbRouter.add_lines();
+        pbLine.set_bus(busLine.bus_id);
+        pbLine.mutable_distances()->Add(busLine.distances.begin(), busLine.distances.end());
+        pbLine.mutable_stops()->Add(busLine.stops.begin(), busLine.stops.end());
+    }
+
+    const size_t edgeCount = router.graph_.GetEdgeCount();
+    pbRouter.mutable_edge_from()->Reserve(edgeCount);
+    pbRouter.mutable_edge_to()->Reserve(edgeCount);
+    pbRouter.mutable_edge_weight()->Reserve(edgeCount);
+    pbRouter.mutable_edge_kind()->Reserve(edgeCount);
+    pbRouter.mutable_edge_bus()->Reserve(edgeCount);
+    pbRouter.mutable_edge_span_count()->Reserve(edgeCount);
+    pbRouter.mutable_edge_distance()->Reserve(edgeCount);
+    pbRouter.mutable_edge_equivalent_bus_count()->Reserve(edgeCount);
+    pbRouter.mutable_equivalent_buses()->Add(router.equivalent_bus_ids_.begin(), router.equivalent_bus_ids_.end());
+    pbRouter.mutable_edge_line()->Reserve(edgeCount);
+    pbRouter.mutable_edge_position()->Reserve(edgeCount);
+    for (Graph::EdgeId edgeId = 0; edgeId < edgeCount; ++edgeId)
+    {
+        const auto& edge = router.graph_.GetEdge(edgeId);
+        pbRouter.add_edge_from(edge.from);
+        pbRouter.add_edge_to(edge.to);
+        pbRouter.add_edge_weight(edge.weight);
+
+        Serialization::TransportRouter::EdgeKind kind = Serialization::TransportRouter::WAIT;
+        int busId = -1;
+        size_t spanCount = 0;
+        size_t equivalentBusCount = 0;
+        size_t lineIdx = 0;
+        size_t position = 0;
+        const auto& edgeInfo = router.edges_info_[edgeId];
+        if (const auto* busEdgeInfo = std::get_if<TransportRouter::BusEdgeInfo>(&edgeInfo))
+        {
+            kind = Serialization::TransportRouter::BUS;
+            busId = busEdgeInfo->bus_id;
+            spanCount = busEdgeInfo->span_count;
+            equivalentBusCount = busEdgeInfo->equivalent_bus_count;
+        }
+        else if (const auto* boardEdgeInfo = std::get_if<TransportRouter::BoardEdgeInfo>(&edgeInfo))
+        {
+            kind = Serialization::TransportRouter::BOARD;
+            lineIdx = boardEdgeInfo->line_idx;
+            position = boardEdgeInfo->position;
+        }
+        else if (std::holds_alternative<TransportRouter::HopEdgeInfo>(edgeInfo))
+        {
+            kind = Serialization::TransportRouter::HOP;
+        }
+        else if (const auto* alightEdgeInfo = std::get_if<TransportRouter::AlightEdgeInfo>(&edgeInfo))
+        {
+            kind = Serialization::TransportRouter::ALIGHT;
+            lineIdx = alightEdgeInfo->line_idx;
+            position = alightEdgeInfo->position;
+        }
+        pbRouter.add_edge_kind(kind);
+        pbRouter.add_edge_bus(busId);
+        pbRouter.add_edge_span_count(spanCount);
+        pbRouter.add_edge_distance(router.edge_distances_[edgeId]);
+        pbRouter.add_edge_equivalent_bus_count(equivalentBusCount);
+        pbRouter.add_edge_line(lineIdx);
+        pbRouter.add_edge_position(position);
+    }
+
+    if (const auto* floydWarshallRouter = dynamic_cast<const Graph::Router<double>*>(router.router_.get()))
+    {
+        MapRoutesTable(floydWarshallRouter->GetRoutesInternalData(), *pbRouter.mutable_routes_table()->mutable_weights(),
+                       *pbRouter.mutable_routes_table());
+    }
+    else if (const auto* fixedPointFloydWarshallRouter = dynamic_cast<const FixedPointFloydWarshallRouter*>(router.router_.get()))
+    {
+        MapRoutesTable(fixedPointFloydWarshallRouter->GetRoutesInternalData(),
+                       *pbRouter.mutable_routes_table()->mutable_fixed_point_weights(), *pbRouter.mutable_routes_table());
+    }
+    else if (const auto* floatFloydWarshallRouter = dynamic_cast<const Graph::Router<double, float>*>(router.router_.get()))
+    {
+        MapRoutesTable(floatFloydWarshallRouter->GetRoutesInternalData(), *pbRouter.mutable_routes_table()->mutable_float_weights(),
+                       *pbRouter.mutable_routes_table());
+    }
+    else if (const auto* contractionHierarchy = dynamic_cast<const ContractionHierarchyRouter*>(router.router_.get()))
+    {
+        MapContractionHierarchy(contractionHierarchy->GetHierarchyData(), *pbRouter.mutable_contraction_hierarchy());
+    }
+    else if (const auto* landmarkRouter = dynamic_cast<const LandmarkRouter*>(router.router_.get()))
+    {
+        MapLandmarks(landmarkRouter->GetLandmarksData(), *pbRouter.mutable_landmarks());
+    }
+    else if (const auto* hubLabelRouter = dynamic_cast<const HubLabelRouter*>(router.router_.get()))
+    {
+        MapHubLabels(hubLabelRouter->GetLabelsData(), *pbRouter.mutable_hub_labels());
+    }
+    return pbRouter;
+}
+
+std::unique_ptr<Router::TransportRouter> Serialization::TransportCatalogProtoMapper::Map(const Serialization::TransportRouter& pbRouter,
+                                                                                        const Router::RoutingSettings& settings)
+{
+    using TransportRouter = Router::TransportRouter;
+    std::unique_ptr<TransportRouter> router(new TransportRouter(settings));
+
+    const size_t vertexCount = pbRouter.vertex_count();
+    router->bus_lines_.reserve(pbRouter.lines_size());
+    for (const auto& pbLine : pbRouter.lines())
+    {
+        router->bus_lines_.push_back(Router::BusLine{
+            .bus_id = pbLine.bus(),
+            .stops = { pbLine.stops().begin(), pbLine.stops().end() },
+            .distances = { pbLine.distances().begin(), pbLine.distances().end() } });
+    }
+
+    router->graph_ = TransportRouter::BusGraph(vertexCount);
+    router->stop_names_.assign(pbRouter.stop_names().begin(), pbRouter.stop_names().end());
+    for (uint32_t stopId = 0; stopId < router->stop_names_.size(); ++stopId)
+    {
+        router->stop_ids_.emplace(router->stop_names_[stopId], stopId);
+    }
+    router->bus_names_.assign(pbRouter.bus_names().begin(), pbRouter.bus_names().end());
+    router->stop_positions_.reserve(pbRouter.stop_positions_size());
+    for (const auto& pbPosition : pbRouter.stop_positions())
+    {
+        router->stop_positions_.push_back(Map(pbPosition));
+    }
+
+    const int edgeCount = pbRouter.edge_from_size();
+    router->edges_info_.reserve(edgeCount);
+    router->edge_distances_.assign(pbRouter.edge_distance().begin(), pbRouter.edge_distance().end());
+    router->equivalent_bus_ids_.assign(pbRouter.equivalent_buses().begin(), pbRouter.equivalent_buses().end());
+    uint32_t equivalentBusesBegin = 0;
+    for (int edgeId = 0; edgeId < edgeCount; ++edgeId)
+    {
+        router->graph_.AddEdge({ pbRouter.edge_from(edgeId), pbRouter.edge_to(edgeId), pbRouter.edge_weight(edgeId) });
+        switch (pbRouter.edge_kind(edgeId))
+        {
+        case Serialization::TransportRouter::BUS:
+            router->edges_info_.push_back(TransportRouter::BusEdgeInfo{
+                .bus_id = static_cast<uint32_t>(pbRouter.edge_bus(edgeId)),
+                .span_count = pbRouter.edge_span_count(edgeId),
+                .equivalent_buses_begin = equivalentBusesBegin,
+                .equivalent_bus_count = pbRouter.edge_equivalent_bus_count(edgeId) });
+            equivalentBusesBegin += pbRouter.edge_equivalent_bus_count(edgeId);
+            break;
+        case Serialization::TransportRouter::BOARD:
+            router->edges_info_.push_back(TransportRouter::BoardEdgeInfo{
+                .line_idx = pbRouter.edge_line(edgeId),
+                .position = pbRouter.edge_position(edgeId) });
+            break;
+        case Serialization::TransportRouter::HOP:
+            router->edges_info_.push_back(TransportRouter::HopEdgeInfo{});
+            break;
+        case Serialization::TransportRouter::ALIGHT:
+            router->edges_info_.push_back(TransportRouter::AlightEdgeInfo{
+                .line_idx = pbRouter.edge_line(edgeId),
+                .position = pbRouter.edge_position(edgeId) });
+            break;
+        default:
+            router->edges_info_.push_back(TransportRouter::WaitEdgeInfo{});
+            break;
+        }
+    }
+    router->graph_.Freeze();
+    router->BuildReachabilityIndex();
+
+    if (pbRouter.has_routes_table() && pbRouter.routes_table().fixed_point_weights_size() > 0)
+    {
+        router->router_ = std::make_unique<FixedPointFloydWarshallRouter>(router->graph_,
+            MapRoutesTable<FixedPointFloydWarshallRouter>(pbRouter.routes_table().fixed_point_weights(), pbRouter.routes_table(), vertexCount));
+    }
+    else if (pbRouter.has_routes_table() && pbRouter.routes_table().float_weights_size() > 0)
+    {
+        using FloydWarshallRouter = Graph::Router<double, float>;
+        router->router_ = std::make_unique<FloydWarshallRouter>(router->graph_,
+            MapRoutesTable<FloydWarshallRouter>(pbRouter.routes_table().float_weights(), pbRouter.routes_table(), vertexCount));
+    }
+    else if (pbRouter.has_routes_table())
+    {
+        using FloydWarshallRouter = Graph::Router<double>;
+        router->router_ = std::make_unique<FloydWarshallRouter>(router->graph_,
+            MapRoutesTable<FloydWarshallRouter>(pbRouter.routes_table().weights(), pbRouter.routes_table(), vertexCount));
+    }
+    else if (pbRouter.has_contraction_hierarchy())
+    {
+        router->router_ = std::make_unique<ContractionHierarchyRouter>(router->graph_,
+            MapContractionHierarchy(pbRouter.contraction_hierarchy()));
+    }
+    else if (pbRouter.has_landmarks())
+    {
+        router->router_ = std::make_unique<LandmarkRouter>(router->graph_, MapLandmarks(pbRouter.landmarks()));
+    }
+    else if (pbRouter.has_hub_labels())
+    {
+        router->router_ = std::make_unique<HubLabelRouter>(router->graph_, MapHubLabels(pbRouter.hub_labels()));
+    }
+    else
+    {
+        router->BuildRouter();
+    }
+    router->BuildRouteCache();
+    return router;
+}
+
 Serialization::RenderSettings Serialization::TransportCatalogProtoMapper::Map(const Visualization::RenderSettings& settings)
 {
     Serialization::RenderSettings pbSettings;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include "transport_catalog.pb.h"
 #include "Point.pb.h"
@@ -55,6 +56,10 @@ namespace Serialization
         static Serialization::RoutingSettings Map(const Router::RoutingSettings& settings);
         static Router::RoutingSettings Map(const Serialization::RoutingSettings& pbSettings);
 
+        static Serialization::TransportRouter Map(const Router::TransportRouter& router);
+        static std::unique_ptr<Router::TransportRouter> Map(const Serialization::TransportRouter& pbRouter,
+                                                            const Router::RoutingSettings& settings);
+
         static Serialization::RenderSettings Map(const Visualization::RenderSettings& settings);
         static Visualization::RenderSettings Map(const Serialization::RenderSettings& pbSettings);
 
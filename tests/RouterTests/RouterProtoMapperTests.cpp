@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include "proto/TransportCatalog/TransportCatalogProtoMapper.h"
+#include "RenderSettings.h"
+#include "TransportDatabase.h"
+#include "TestNetworks.h"
+
+using namespace Router;
+using namespace Router::Tests;
+
+namespace
+{
+    TransportDatabase MakeDatabase(const Descriptions::InputQueries &network, RoutingEngine engine, bool floatRoutesTable = false)
+    {
+        return TransportDatabase(network,
+                                 Router::RoutingSettings{.bus_wait_time = 3,
+                                                         .bus_velocity = 35.0,
+                                                         .routing_engine = engine,
+                                                         .float_routes_table = floatRoutesTable},
+                                 Visualization::RenderSettings{});
+    }
+
+    void ExpectSameRoutes(const Descriptions::InputQueries &network, const TransportDatabase &expected, const TransportDatabase &actual)
+    {
+        for (const auto &from : network.stops)
+        {
+            for (const auto &to : network.stops)
+            {
+                const auto expectedRoute = expected.FindRoute(from.name, to.name);
+                const auto actualRoute = actual.FindRoute(from.name, to.name);
+                ASSERT_EQ(expectedRoute.has_value(), actualRoute.has_value());
+                if (expectedRoute)
+                {
+                    EXPECT_EQ(expectedRoute->total_time, actualRoute->total_time);
+                    EXPECT_EQ(expectedRoute->items.size(), actualRoute->items.size());
+                }
+            }
+        }
+    }
+}
+
+TEST(RouterProtoMapperTests, RoutesTableIsPersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 3);
+    const auto db = MakeDatabase(network, RoutingEngine::FloydWarshall);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    ASSERT_TRUE(catalog.has_router());
+    EXPECT_EQ(catalog.router().stop_names_size(), 30);
+    EXPECT_EQ(catalog.router().routes_table().weights_size(), 60 * 60);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, FloatRoutesTableIsPersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 5);
+    const auto db = MakeDatabase(network, RoutingEngine::FloydWarshall, true);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_EQ(catalog.router().routes_table().weights_size(), 0);
+    EXPECT_EQ(catalog.router().routes_table().float_weights_size(), 60 * 60);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, FixedPointRoutesTableIsPersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 19);
+    const TransportDatabase db(network,
+                               Router::RoutingSettings{.bus_wait_time = 3,
+                                                       .bus_velocity = 36.0,
+                                                       .fixed_point_routes_table = true},
+                               Visualization::RenderSettings{});
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_EQ(catalog.router().routes_table().fixed_point_weights_size(), 60 * 60);
+    EXPECT_EQ(catalog.router().routes_table().weights_size(), 0);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, GraphIsPersistedWithoutTable)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 4);
+    const auto db = MakeDatabase(network, RoutingEngine::Dijkstra);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    ASSERT_TRUE(catalog.has_router());
+    EXPECT_FALSE(catalog.router().has_routes_table());
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, ContractionHierarchyIsPersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 6);
+    const auto db = MakeDatabase(network, RoutingEngine::ContractionHierarchy);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_FALSE(catalog.router().has_routes_table());
+    ASSERT_TRUE(catalog.router().has_contraction_hierarchy());
+    EXPECT_EQ(catalog.router().contraction_hierarchy().ranks_size(), 60);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, LineExpandedGraphIsPersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 12, 7);
+    const auto stopPairsDb = MakeDatabase(network, RoutingEngine::Dijkstra);
+    const auto db = TransportDatabase(network,
+                                      Router::RoutingSettings{.bus_wait_time = 3,
+                                                              .bus_velocity = 35.0,
+                                                              .routing_engine = RoutingEngine::ContractionHierarchy,
+                                                              .graph_model = GraphModel::LineExpanded},
+                                      Visualization::RenderSettings{});
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_EQ(catalog.router().lines_size(), 6);
+    EXPECT_LT(catalog.router().edge_from_size(), Serialization::TransportCatalogProtoMapper::Map(stopPairsDb).router().edge_from_size());
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, RaptorLinesArePersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 12, 8);
+    const auto db = MakeDatabase(network, RoutingEngine::Raptor);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_FALSE(catalog.router().has_routes_table());
+    ASSERT_EQ(catalog.router().lines_size(), 6);
+    EXPECT_EQ(catalog.router().lines(0).stops_size(), catalog.router().lines(0).distances_size());
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, AStarStopPositionsArePersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 9);
+    const auto db = MakeDatabase(network, RoutingEngine::AStar);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_FALSE(catalog.router().has_routes_table());
+    EXPECT_EQ(catalog.router().stop_positions_size(), 30);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, LandmarksArePersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 10);
+    const auto db = MakeDatabase(network, RoutingEngine::Alt);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    ASSERT_TRUE(catalog.router().has_landmarks());
+    EXPECT_EQ(catalog.router().landmarks().vertices_size(), 8);
+    EXPECT_EQ(catalog.router().landmarks().from_distances_size(), 8 * 60);
+    EXPECT_EQ(catalog.router().stop_positions_size(), 0);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, HubLabelsArePersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 16);
+    const auto db = MakeDatabase(network, RoutingEngine::HubLabels);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    ASSERT_TRUE(catalog.router().has_hub_labels());
+    EXPECT_EQ(catalog.router().hub_labels().out_label_begins_size(), static_cast<int>(catalog.router().vertex_count()) + 1);
+    EXPECT_FALSE(catalog.router().has_routes_table());
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+}
+
+TEST(RouterProtoMapperTests, EdgeDistancesArePersisted)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 12);
+    const auto db = MakeDatabase(network, RoutingEngine::FloydWarshall);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_EQ(catalog.router().edge_distance_size(), catalog.router().edge_from_size());
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    Router::RoutingSettings metric = db.GetRoutingSettings();
+    metric.bus_wait_time = 7;
+    metric.bus_velocity = 50.0;
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            const auto expectedRoute = db.FindRoute(from.name, to.name, metric);
+            const auto actualRoute = restoredDb.FindRoute(from.name, to.name, metric);
+            ASSERT_EQ(expectedRoute.has_value(), actualRoute.has_value());
+            if (expectedRoute)
+            {
+                EXPECT_EQ(expectedRoute->total_time, actualRoute->total_time);
+                EXPECT_EQ(expectedRoute->items.size(), actualRoute->items.size());
+            }
+        }
+    }
+}
+
+TEST(RouterProtoMapperTests, EquivalentBusesArePersisted)
+{
+    auto network = MakeRandomNetwork(30, 6, 6, 15);
+    auto twinBus = network.buses.front();
+    twinBus.name = "Bus twin";
+    network.buses.push_back(twinBus);
+    const auto db = MakeDatabase(network, RoutingEngine::Dijkstra);
+    const auto catalog = Serialization::TransportCatalogProtoMapper::Map(db);
+    EXPECT_EQ(catalog.router().edge_equivalent_bus_count_size(), catalog.router().edge_from_size());
+    EXPECT_GT(catalog.router().equivalent_buses_size(), 0);
+
+    const auto restoredDb = Serialization::TransportCatalogProtoMapper::Map(catalog);
+    ExpectSameRoutes(network, db, restoredDb);
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            const auto expectedRoute = db.FindRoute(from.name, to.name);
+            const auto actualRoute = restoredDb.FindRoute(from.name, to.name);
+            if (!expectedRoute)
+            {
+                continue;
+            }
+            for (size_t itemIdx = 0; itemIdx < expectedRoute->items.size(); ++itemIdx)
+            {
+                const auto *expectedItem = std::get_if<TransportRouter::RouteInfo::BusItem>(&expectedRoute->items[itemIdx]);
+                const auto *actualItem = std::get_if<TransportRouter::RouteInfo::BusItem>(&actualRoute->items[itemIdx]);
+                ASSERT_EQ(expectedItem == nullptr, actualItem == nullptr);
+                if (expectedItem)
+                {
+                    EXPECT_TRUE(std::equal(expectedItem->equivalent_bus_ids.begin(), expectedItem->equivalent_bus_ids.end(),
+                                           actualItem->equivalent_bus_ids.begin(), actualItem->equivalent_bus_ids.end()));
+                }
+            }
+        }
+    }
+}
+
+TEST(RouterProtoMapperTests, GraphDoesNotDependOnThreadCount)
+{
+    auto network = MakeRandomNetwork(60, 12, 10, 24);
+    network.buses.push_back(network.buses.front());
+    network.buses.back().name = "Bus twin";
+    auto makeCatalog = [&network](int threadCount) {
+        const TransportDatabase db(network,
+                                   Router::RoutingSettings{.bus_wait_time = 3,
+                                                           .bus_velocity = 35.0,
+                                                           .routing_engine = RoutingEngine::Dijkstra,
+                                                           .routing_threads = threadCount},
+                                   Visualization::RenderSettings{});
+        return Serialization::TransportCatalogProtoMapper::Map(db);
+    };
+    const auto sequential = makeCatalog(1);
+    EXPECT_GT(sequential.router().equivalent_buses_size(), 0);
+    for (const int threadCount : {2, 3, 8})
+    {
+        EXPECT_EQ(sequential.router().SerializeAsString(), makeCatalog(threadCount).router().SerializeAsString()) << threadCount;
+    }
+}
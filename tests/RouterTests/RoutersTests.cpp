@@ -0,0 +1,451 @@
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <vector>
+#include <gtest/gtest.h>
+#include "AStarRouter.h"
+#include "BidirectionalDijkstraRouter.h"
+#include "ContractionHierarchy.h"
+#include "DijkstraRouter.h"
+#include "HubLabelRouter.h"
+#include "LandmarkRouter.h"
+#include "ReachabilityIndex.h"
+#include "Router.h"
+#include "ShortestPathTreeCache.h"
+#include "TestNetworks.h"
+
+using namespace Router::Tests;
+
+namespace
+{
+    std::optional<double> FindWeight(const Graph::IRouter<double> &router, Graph::VertexId from, Graph::VertexId to)
+    {
+        std::vector<Graph::EdgeId> edges;
+        return router.FindRoute(from, to, edges);
+    }
+
+    // Compares every pair answered by the router with the Floyd-Warshall table
+    void ExpectSameAsFloydWarshall(const Graph::DirectedWeightedGraph<double> &graph, const Graph::IRouter<double> &router)
+    {
+        Graph::Router<double> reference(graph);
+        std::vector<Graph::EdgeId> edges;
+        for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+        {
+            for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+            {
+                const auto expected = FindWeight(reference, from, to);
+                const auto actual = router.FindRoute(from, to, edges);
+                ASSERT_EQ(expected.has_value(), actual.has_value()) << from << " -> " << to;
+                if (!expected)
+                {
+                    continue;
+                }
+                EXPECT_NEAR(*expected, *actual, 1e-9) << from << " -> " << to;
+                EXPECT_NEAR(ComputePathWeight(graph, from, to, edges), *actual, 1e-9);
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, FrozenGraphArcsFollowIncidentEdges)
+{
+    const auto graph = MakeRandomGraph(30, 120, 3);
+    Graph::DirectedWeightedGraph<double> unfrozen(graph.GetVertexCount());
+    for (Graph::EdgeId edgeId = 0; edgeId < graph.GetEdgeCount(); ++edgeId)
+    {
+        unfrozen.AddEdge(graph.GetEdge(edgeId));
+    }
+    EXPECT_FALSE(unfrozen.IsFrozen());
+    EXPECT_TRUE(graph.IsFrozen());
+    for (Graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex)
+    {
+        const auto incidentEdges = unfrozen.GetIncidentEdges(vertex);
+        std::vector<Graph::EdgeId> expected(incidentEdges.begin(), incidentEdges.end());
+        std::vector<Graph::EdgeId> actual;
+        for (const auto arc : graph.GetOutgoingArcs(vertex))
+        {
+            const auto &edge = graph.GetEdge(arc.edge_id);
+            EXPECT_EQ(edge.from, vertex);
+            EXPECT_EQ(edge.to, arc.to);
+            EXPECT_EQ(edge.weight, arc.weight);
+            actual.push_back(arc.edge_id);
+        }
+        EXPECT_EQ(expected, actual);
+        const auto frozenIncidentEdges = graph.GetIncidentEdges(vertex);
+        EXPECT_EQ(expected, std::vector<Graph::EdgeId>(frozenIncidentEdges.begin(), frozenIncidentEdges.end()));
+    }
+}
+
+TEST(RoutersTests, DijkstraMatchesFloydWarshall)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        Graph::DijkstraRouter<double> router(graph);
+        ExpectSameAsFloydWarshall(graph, router);
+    }
+}
+
+TEST(RoutersTests, DijkstraRouteToItself)
+{
+    const auto graph = MakeRandomGraph(10, 30, 42);
+    Graph::DijkstraRouter<double> router(graph);
+    std::vector<Graph::EdgeId> edges = {0};
+    const auto weight = router.FindRoute(3, 3, edges);
+    ASSERT_TRUE(weight.has_value());
+    EXPECT_EQ(*weight, 0.0);
+    EXPECT_TRUE(edges.empty());
+}
+
+TEST(RoutersTests, DijkstraUnreachableVertex)
+{
+    const auto graph = MakeRandomGraph(10, 30, 7);
+    Graph::DijkstraRouter<double> router(graph);
+    EXPECT_FALSE(FindWeight(router, 0, 9).has_value());
+}
+
+TEST(RoutersTests, AStarMatchesFloydWarshallWithInconsistentHeuristic)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        // Exact distances for even vertices and none for odd ones: admissible but not consistent
+        const auto reference = std::make_shared<Graph::Router<double>>(graph);
+        Graph::AStarRouter<double> router(graph, [reference](Graph::VertexId vertex, Graph::VertexId to) {
+            const auto weight = vertex % 2 == 0 ? FindWeight(*reference, vertex, to) : std::nullopt;
+            return weight.value_or(0.0);
+        });
+        ExpectSameAsFloydWarshall(graph, router);
+    }
+}
+
+TEST(RoutersTests, AStarReusesBuffersAcrossGraphs)
+{
+    const auto bigGraph = MakeRandomGraph(80, 320, 23);
+    const auto smallGraph = MakeRandomGraph(20, 60, 24);
+    const auto zero = [](Graph::VertexId, Graph::VertexId) { return 0.0; };
+    Graph::AStarRouter<double> bigRouter(bigGraph, zero);
+    Graph::AStarRouter<double> smallRouter(smallGraph, zero);
+    Graph::Router<double> smallReference(smallGraph);
+    for (Graph::VertexId from = 0; from < smallGraph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < smallGraph.GetVertexCount(); ++to)
+        {
+            FindWeight(bigRouter, to, from);
+            const auto expected = FindWeight(smallReference, from, to);
+            const auto actual = FindWeight(smallRouter, from, to);
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-9);
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, LandmarkRouterMatchesFloydWarshall)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        std::vector<Graph::VertexId> candidates(graph.GetVertexCount());
+        std::iota(candidates.begin(), candidates.end(), 0);
+        const auto landmarks = Graph::LandmarkRouter<double>::SelectFarthestLandmarks(graph, candidates, 4);
+        EXPECT_EQ(landmarks.size(), 4u);
+        Graph::LandmarkRouter<double> router(graph, landmarks);
+        ExpectSameAsFloydWarshall(graph, router);
+    }
+}
+
+TEST(RoutersTests, BidirectionalDijkstraMatchesFloydWarshall)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        Graph::BidirectionalDijkstraRouter<double> router(graph);
+        ExpectSameAsFloydWarshall(graph, router);
+    }
+}
+
+TEST(RoutersTests, BidirectionalDijkstraReusesBuffersAcrossGraphs)
+{
+    // Routers of one thread share buffers, stale stamps of a bigger graph must not leak
+    const auto bigGraph = MakeRandomGraph(80, 320, 21);
+    const auto smallGraph = MakeRandomGraph(20, 60, 22);
+    Graph::BidirectionalDijkstraRouter<double> bigRouter(bigGraph);
+    Graph::BidirectionalDijkstraRouter<double> smallRouter(smallGraph);
+    Graph::Router<double> smallReference(smallGraph);
+    for (Graph::VertexId from = 0; from < smallGraph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < smallGraph.GetVertexCount(); ++to)
+        {
+            FindWeight(bigRouter, to, from);
+            const auto expected = FindWeight(smallReference, from, to);
+            const auto actual = FindWeight(smallRouter, from, to);
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-9);
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, ContractionHierarchyWeightsTableMatchesFloydWarshall)
+{
+    const auto graph = MakeRandomGraph(60, 240, 31);
+    Graph::Router<double> reference(graph);
+    Graph::ContractionHierarchy<double> router(graph);
+    const std::vector<Graph::VertexId> sources = {0, 5, 17, 59, 5};
+    const std::vector<Graph::VertexId> targets = {3, 59, 0, 42, 17, 17};
+    const auto table = router.BuildWeightsTable(sources, targets);
+    ASSERT_EQ(table.size(), sources.size() * targets.size());
+    for (size_t sourceIdx = 0; sourceIdx < sources.size(); ++sourceIdx)
+    {
+        for (size_t targetIdx = 0; targetIdx < targets.size(); ++targetIdx)
+        {
+            const auto expected = FindWeight(reference, sources[sourceIdx], targets[targetIdx]);
+            const auto &actual = table[sourceIdx * targets.size() + targetIdx];
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-9);
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, FloatRoutesTableMatchesDoubleOne)
+{
+    const auto graph = MakeRandomGraph(60, 240, 11);
+    Graph::Router<double> reference(graph);
+    Graph::Router<double, float> router(graph);
+    for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+        {
+            const auto expected = FindWeight(reference, from, to);
+            const auto actual = FindWeight(router, from, to);
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-3);
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, FixedPointRoutesTableMatchesDoubleOne)
+{
+    // Weights in whole thousandths are exact in the fixed point table
+    const auto randomGraph = MakeRandomGraph(60, 240, 18);
+    Graph::DirectedWeightedGraph<double> graph(randomGraph.GetVertexCount());
+    for (Graph::EdgeId edgeId = 0; edgeId < randomGraph.GetEdgeCount(); ++edgeId)
+    {
+        auto edge = randomGraph.GetEdge(edgeId);
+        edge.weight = std::round(edge.weight * 1000) / 1000;
+        graph.AddEdge(edge);
+    }
+    graph.Freeze();
+
+    const Graph::Router<double> reference(graph);
+    const Graph::Router<double, uint32_t, 1000> router(graph, 4);
+    std::vector<Graph::EdgeId> edges;
+    for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+        {
+            const auto expected = FindWeight(reference, from, to);
+            const auto actual = router.FindRoute(from, to, edges);
+            ASSERT_EQ(expected.has_value(), actual.has_value()) << from << " -> " << to;
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-9) << from << " -> " << to;
+                EXPECT_NEAR(ComputePathWeight(graph, from, to, edges), *actual, 1e-9);
+            }
+        }
+    }
+    EXPECT_EQ(sizeof(router.GetRoutesInternalData().weights[0]), 4u);
+}
+
+TEST(RoutersTests, FixedPointRoutesTableSaturatesLongRoutes)
+{
+    using FixedPointRouter = Graph::Router<double, uint32_t, 1000>;
+    EXPECT_TRUE(FixedPointRouter::CanStoreRoutes(MakeRandomGraph(60, 240, 18)));
+
+    // Every hop fits, a route of three of them does not
+    const double hopWeight = FixedPointRouter::NoRoute / 1000 * 0.4;
+    Graph::DirectedWeightedGraph<double> graph(4);
+    for (Graph::VertexId vertex = 0; vertex + 1 < 4; ++vertex)
+    {
+        graph.AddEdge({vertex, vertex + 1, hopWeight});
+    }
+    graph.Freeze();
+    EXPECT_FALSE(FixedPointRouter::CanStoreRoutes(graph));
+    const FixedPointRouter router(graph);
+    std::vector<Graph::EdgeId> edges;
+    EXPECT_NEAR(*router.FindRoute(0, 2, edges), 2 * hopWeight, 1e-3);
+    EXPECT_FALSE(router.FindRoute(0, 3, edges).has_value());
+}
+
+TEST(RoutersTests, RoutesTableIsFlat)
+{
+    const auto graph = MakeRandomGraph(50, 200, 12);
+    const Graph::Router<double, float> router(graph);
+    const auto &table = router.GetRoutesInternalData();
+    EXPECT_EQ(table.vertex_count, 50u);
+    EXPECT_EQ(table.weights.size(), 50u * 50u);
+    EXPECT_EQ(table.prev_edges.size(), 50u * 50u);
+    EXPECT_EQ(sizeof(table.weights[0]) + sizeof(table.prev_edges[0]), 8u);
+}
+
+TEST(RoutersTests, BlockedFloydWarshallDoesNotDependOnThreadCount)
+{
+    // More than one tile in each dimension
+    const auto graph = MakeRandomGraph(150, 600, 13);
+    const Graph::Router<double> singleThreadRouter(graph, 1);
+    const Graph::Router<double> multiThreadRouter(graph, 4);
+    const auto &expected = singleThreadRouter.GetRoutesInternalData();
+    const auto &actual = multiThreadRouter.GetRoutesInternalData();
+    EXPECT_EQ(expected.weights, actual.weights);
+    EXPECT_EQ(expected.prev_edges, actual.prev_edges);
+}
+
+TEST(RoutersTests, BlockedFloydWarshallMatchesDijkstra)
+{
+    const auto graph = MakeRandomGraph(150, 600, 14);
+    const Graph::Router<double> router(graph, 4);
+    Graph::DijkstraRouter<double> reference(graph);
+    std::vector<Graph::EdgeId> edges;
+    for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+        {
+            const auto expected = FindWeight(reference, from, to);
+            const auto actual = router.FindRoute(from, to, edges);
+            ASSERT_EQ(expected.has_value(), actual.has_value());
+            if (!expected)
+            {
+                continue;
+            }
+            EXPECT_NEAR(*expected, *actual, 1e-9);
+            EXPECT_NEAR(ComputePathWeight(graph, from, to, edges), *actual, 1e-9);
+        }
+    }
+}
+
+TEST(RoutersTests, ContractionHierarchyMatchesFloydWarshall)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        Graph::ContractionHierarchy<double> router(graph);
+        ExpectSameAsFloydWarshall(graph, router);
+    }
+}
+
+TEST(RoutersTests, RestoredContractionHierarchyMatchesFloydWarshall)
+{
+    const auto graph = MakeRandomGraph(60, 240, 13);
+    const Graph::ContractionHierarchy<double> built(graph);
+    Graph::ContractionHierarchy<double> restored(graph, built.GetHierarchyData());
+    ExpectSameAsFloydWarshall(graph, restored);
+}
+
+TEST(RoutersTests, HubLabelRouterMatchesFloydWarshall)
+{
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 240, seed);
+        Graph::HubLabelRouter<double> router(graph);
+        ExpectSameAsFloydWarshall(graph, router);
+        Graph::Router<double> reference(graph);
+        for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+        {
+            for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+            {
+                const auto expected = FindWeight(reference, from, to);
+                const auto actual = router.FindWeight(from, to);
+                ASSERT_EQ(expected.has_value(), actual.has_value()) << from << " -> " << to;
+                if (expected)
+                {
+                    EXPECT_NEAR(*expected, *actual, 1e-9) << from << " -> " << to;
+                }
+            }
+        }
+    }
+}
+
+TEST(RoutersTests, RestoredHubLabelRouterMatchesFloydWarshall)
+{
+    const auto graph = MakeRandomGraph(60, 240, 17);
+    const Graph::HubLabelRouter<double> built(graph);
+    Graph::HubLabelRouter<double> restored(graph, built.GetLabelsData());
+    ExpectSameAsFloydWarshall(graph, restored);
+}
+
+TEST(RoutersTests, ShortestPathTreeCacheMatchesFloydWarshall)
+{
+    const auto graph = MakeRandomGraph(60, 240, 19);
+    const Graph::Router<double> reference(graph);
+    const size_t treeBytes = graph.GetVertexCount() * (sizeof(double) + sizeof(uint32_t));
+    const Graph::ShortestPathTreeCache<double> cache(graph, 3 * treeBytes);
+    EXPECT_EQ(cache.GetTreeCapacity(), 3u);
+
+    std::vector<Graph::EdgeId> edges;
+    for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+    {
+        for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+        {
+            const auto expected = FindWeight(reference, from, to);
+            const auto actual = cache.FindRoute(from, to, edges);
+            ASSERT_EQ(expected.has_value(), actual.has_value()) << from << " -> " << to;
+            if (expected)
+            {
+                EXPECT_NEAR(*expected, *actual, 1e-9) << from << " -> " << to;
+                EXPECT_NEAR(ComputePathWeight(graph, from, to, edges), *actual, 1e-9);
+            }
+        }
+    }
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.misses, graph.GetVertexCount());
+    EXPECT_EQ(stats.hits, graph.GetVertexCount() * (graph.GetVertexCount() - 1));
+
+    // Origins 57, 58 and 59 are cached, 0 was evicted long ago
+    cache.FindRoute(58, 0, edges);
+    cache.FindRoute(0, 58, edges);
+    stats = cache.GetStats();
+    EXPECT_EQ(stats.misses, graph.GetVertexCount() + 1);
+    EXPECT_EQ(stats.hits, graph.GetVertexCount() * (graph.GetVertexCount() - 1) + 1);
+}
+
+TEST(RoutersTests, ReachabilityIndexMatchesFloydWarshall)
+{
+    // Sparse graphs have many strong components and unreachable pairs
+    for (unsigned seed = 0; seed < 5; ++seed)
+    {
+        const auto graph = MakeRandomGraph(60, 40 + 20 * seed, seed);
+        Graph::Router<double> reference(graph);
+        const Graph::ReachabilityIndex<double> index(graph);
+        const Graph::ReachabilityIndex<double> inexactIndex(graph, 0);
+        EXPECT_TRUE(index.IsExact());
+        EXPECT_FALSE(inexactIndex.IsExact());
+        EXPECT_GT(index.GetComponentCount(), 1u);
+        size_t unreachableCount = 0;
+        for (Graph::VertexId from = 0; from < graph.GetVertexCount(); ++from)
+        {
+            for (Graph::VertexId to = 0; to < graph.GetVertexCount(); ++to)
+            {
+                const bool isReachable = FindWeight(reference, from, to).has_value();
+                EXPECT_EQ(index.MayReach(from, to), isReachable) << from << " -> " << to;
+                if (isReachable)
+                {
+                    EXPECT_TRUE(inexactIndex.MayReach(from, to)) << from << " -> " << to;
+                }
+                unreachableCount += !isReachable;
+            }
+        }
+        EXPECT_GT(unreachableCount, 0u);
+    }
+}
@@ -0,0 +1,142 @@
+#include "TestNetworks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <variant>
+#include <gtest/gtest.h>
+#include "Sphere.h"
+
+namespace Router::Tests
+{
+    Graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertexCount, size_t edgeCount, unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<size_t> vertexDistribution(0, vertexCount - 1);
+        std::uniform_real_distribution<double> weightDistribution(0.0, 10.0);
+
+        Graph::DirectedWeightedGraph<double> graph(vertexCount);
+        // The last vertex has no incoming edges
+        for (size_t i = 0; i < edgeCount; ++i)
+        {
+            const Graph::VertexId from = vertexDistribution(generator);
+            const Graph::VertexId to = vertexDistribution(generator);
+            if (to == vertexCount - 1)
+            {
+                continue;
+            }
+            const double weight = i % 10 == 0 ? std::round(weightDistribution(generator)) : weightDistribution(generator);
+            graph.AddEdge({from, to, weight});
+        }
+        graph.Freeze();
+        return graph;
+    }
+
+    Descriptions::InputQueries MakeRandomNetwork(size_t stopCount, size_t busCount, size_t stopsPerBus, unsigned seed)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> coordDistribution(0.0, 0.1);
+        std::uniform_real_distribution<double> detourDistribution(1.0, 1.5);
+
+        Descriptions::InputQueries network;
+        network.stops.reserve(stopCount);
+        for (size_t i = 0; i < stopCount; ++i)
+        {
+            network.stops.push_back(Descriptions::Stop{
+                .name = "Stop " + std::to_string(i),
+                .position = {.latitude = 55.6 + coordDistribution(generator),
+                             .longitude = 37.5 + coordDistribution(generator)},
+                .distances = {}});
+        }
+
+        std::vector<size_t> stopIndices(stopCount);
+        std::iota(begin(stopIndices), end(stopIndices), 0);
+        for (size_t i = 0; i < busCount; ++i)
+        {
+            std::shuffle(begin(stopIndices), end(stopIndices), generator);
+            const size_t routeLength = std::min(stopsPerBus, stopCount);
+            std::vector<std::string> stops;
+            for (size_t j = 0; j < routeLength; ++j)
+            {
+                stops.push_back(network.stops[stopIndices[j]].name);
+            }
+            const bool isRoundtrip = i % 2 == 0;
+            if (isRoundtrip)
+            {
+                stops.push_back(stops.front());
+            }
+            else
+            {
+                for (size_t j = routeLength - 1; j > 0; --j)
+                {
+                    stops.push_back(stops[j - 1]);
+                }
+            }
+
+            for (size_t j = 0; j + 1 < stops.size(); ++j)
+            {
+                auto &lhs = network.stops[std::stoul(stops[j].substr(5))];
+                const auto &rhs = network.stops[std::stoul(stops[j + 1].substr(5))];
+                if (lhs.distances.count(rhs.name) == 0)
+                {
+                    const double geoDistance = Sphere::Distance(lhs.position, rhs.position);
+                    lhs.distances[rhs.name] = static_cast<int>(std::ceil(geoDistance * detourDistribution(generator)));
+                }
+            }
+
+            network.buses.push_back(Descriptions::Bus{
+                .name = "Bus " + std::to_string(i),
+                .stops = std::move(stops),
+                .isRoundtrip = isRoundtrip});
+        }
+        return network;
+    }
+
+    Descriptions::StopsDict MakeStopsDict(const Descriptions::InputQueries& network)
+    {
+        Descriptions::StopsDict stopsDict;
+        for (const auto &stop : network.stops)
+        {
+            stopsDict[stop.name] = &stop;
+        }
+        return stopsDict;
+    }
+
+    Descriptions::BusesDict MakeBusesDict(const Descriptions::InputQueries& network)
+    {
+        Descriptions::BusesDict busesDict;
+        for (const auto &bus : network.buses)
+        {
+            busesDict[bus.name] = &bus;
+        }
+        return busesDict;
+    }
+
+    double ComputeItemsTime(const TransportRouter::RouteInfo& route)
+    {
+        double time = 0.0;
+        for (const auto &item : route.items)
+        {
+            time += std::visit([](const auto &i) { return i.time; }, item);
+        }
+        return time;
+    }
+
+    double ComputePathWeight(const Graph::DirectedWeightedGraph<double>& graph,
+                             Graph::VertexId from, Graph::VertexId to,
+                             const std::vector<Graph::EdgeId>& edges)
+    {
+        double weight = 0.0;
+        Graph::VertexId current = from;
+        for (const auto edgeId : edges)
+        {
+            const auto &edge = graph.GetEdge(edgeId);
+            EXPECT_EQ(edge.from, current);
+            weight += edge.weight;
+            current = edge.to;
+        }
+        EXPECT_EQ(current, to);
+        return weight;
+    }
+}
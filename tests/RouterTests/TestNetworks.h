@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Descriptions.h"
+#include "Graph.h"
+#include "TransportRouter.h"
+
+namespace Router::Tests
+{
+    // Random frozen graph with non negative weights, some vertices are left unreachable
+    Graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertexCount, size_t edgeCount, unsigned seed);
+
+    // Random stops and buses; every road distance is not shorter than the geo distance
+    Descriptions::InputQueries MakeRandomNetwork(size_t stopCount, size_t busCount, size_t stopsPerBus, unsigned seed);
+
+    Descriptions::StopsDict MakeStopsDict(const Descriptions::InputQueries& network);
+    Descriptions::BusesDict MakeBusesDict(const Descriptions::InputQueries& network);
+
+    // Sum of route items times
+    double ComputeItemsTime(const TransportRouter::RouteInfo& route);
+
+    // Checks that edges form a path from 'from' to 'to' and returns its weight
+    double ComputePathWeight(const Graph::DirectedWeightedGraph<double>& graph,
+                             Graph::VertexId from, Graph::VertexId to,
+                             const std::vector<Graph::EdgeId>& edges);
+}
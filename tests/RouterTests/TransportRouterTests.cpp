@@ -0,0 +1,799 @@
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <thread>
+#include <gtest/gtest.h>
+#include "RenderSettings.h"
+#include "Requests.h"
+#include "TransportDatabase.h"
+#include "TransportRouter.h"
+#include "TestNetworks.h"
+
+using namespace Router;
+using namespace Router::Tests;
+
+namespace
+{
+    const RoutingSettings DefaultSettings = {.bus_wait_time = 6, .bus_velocity = 40.0};
+
+    void ExpectSameRoutes(const Descriptions::InputQueries &network,
+                          const TransportRouter &expectedRouter,
+                          const TransportRouter &actualRouter)
+    {
+        for (const auto &from : network.stops)
+        {
+            for (const auto &to : network.stops)
+            {
+                const auto expected = expectedRouter.FindRoute(from.name, to.name);
+                const auto actual = actualRouter.FindRoute(from.name, to.name);
+                ASSERT_EQ(expected.has_value(), actual.has_value()) << from.name << " -> " << to.name;
+                if (!expected)
+                {
+                    continue;
+                }
+                EXPECT_NEAR(expected->total_time, actual->total_time, 1e-9) << from.name << " -> " << to.name;
+                EXPECT_NEAR(actual->total_time, ComputeItemsTime(*actual), 1e-9);
+            }
+        }
+    }
+
+    RoutingSettings WithEngine(RoutingEngine engine)
+    {
+        RoutingSettings settings = DefaultSettings;
+        settings.routing_engine = engine;
+        return settings;
+    }
+}
+
+TEST(TransportRouterTests, DijkstraEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 1);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    const TransportRouter actual(stopsDict, busesDict, WithEngine(RoutingEngine::Dijkstra));
+    ExpectSameRoutes(network, expected, actual);
+}
+
+TEST(TransportRouterTests, ContractionHierarchyEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 2);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    const TransportRouter actual(stopsDict, busesDict, WithEngine(RoutingEngine::ContractionHierarchy));
+    ExpectSameRoutes(network, expected, actual);
+}
+
+TEST(TransportRouterTests, BidirectionalDijkstraEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 8);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, WithEngine(RoutingEngine::BidirectionalDijkstra)));
+}
+
+TEST(TransportRouterTests, HubLabelsEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 16);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, WithEngine(RoutingEngine::HubLabels)));
+}
+
+TEST(TransportRouterTests, FixedPointRoutesTableMatchesDoubleOne)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 18);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    RoutingSettings settings = DefaultSettings;
+    settings.fixed_point_routes_table = true;
+    // Ride times are whole milliseconds at 40 km/h
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+}
+
+TEST(TransportRouterTests, FixedPointRouteTimesAreSumsOfItems)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 19);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    // Ride times are not whole milliseconds, the table rounds every edge
+    RoutingSettings settings = DefaultSettings;
+    settings.bus_velocity = 37.3;
+    const TransportRouter expected(stopsDict, busesDict, settings);
+    settings.fixed_point_routes_table = true;
+    const TransportRouter actual(stopsDict, busesDict, settings);
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            const auto expectedRoute = expected.FindRoute(from.name, to.name);
+            const auto actualRoute = actual.FindRoute(from.name, to.name);
+            ASSERT_EQ(expectedRoute.has_value(), actualRoute.has_value()) << from.name << " -> " << to.name;
+            if (!actualRoute)
+            {
+                continue;
+            }
+            EXPECT_DOUBLE_EQ(actualRoute->total_time, ComputeItemsTime(*actualRoute)) << from.name << " -> " << to.name;
+            // Rounding may pick a route a few milliseconds longer than the exact shortest one
+            EXPECT_NEAR(expectedRoute->total_time, actualRoute->total_time, 10.0 / 60'000) << from.name << " -> " << to.name;
+        }
+    }
+}
+
+TEST(TransportRouterTests, FixedPointRoutesTableFallsBackForLongRoutes)
+{
+    const auto network = MakeRandomNetwork(20, 4, 5, 32);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    // Rides of months: routes in milliseconds exceed the integer table
+    RoutingSettings settings = DefaultSettings;
+    settings.bus_velocity = 0.001;
+    const TransportRouter expected(stopsDict, busesDict, settings);
+    settings.fixed_point_routes_table = true;
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+}
+
+TEST(TransportRouterTests, RouteCacheMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 20);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    RoutingSettings settings = WithEngine(RoutingEngine::Dijkstra);
+    settings.route_cache_bytes = 1 << 20;
+    const TransportRouter actual(stopsDict, busesDict, settings);
+    ExpectSameRoutes(network, expected, actual);
+    // Routes the reachability index rejects never get to the cache
+    size_t routeCount = 0;
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            routeCount += expected.FindRoute(from.name, to.name).has_value();
+        }
+    }
+    const auto stats = actual.GetRouteCacheStats();
+    EXPECT_EQ(stats.misses, network.stops.size());
+    EXPECT_EQ(stats.hits, routeCount - network.stops.size());
+
+    // The budget is below one tree
+    settings.route_cache_bytes = 10;
+    const TransportRouter uncached(stopsDict, busesDict, settings);
+    ExpectSameRoutes(network, expected, uncached);
+    EXPECT_EQ(uncached.GetRouteCacheStats().misses, 0u);
+
+    // Engines with preprocessing answer routes themselves
+    settings = WithEngine(RoutingEngine::ContractionHierarchy);
+    settings.route_cache_bytes = 1 << 20;
+    const TransportRouter hierarchy(stopsDict, busesDict, settings);
+    ExpectSameRoutes(network, expected, hierarchy);
+    EXPECT_EQ(hierarchy.GetRouteCacheStats().misses, 0u);
+}
+
+TEST(TransportRouterTests, AutoEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 21);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    const size_t routeCount = network.stops.size() * network.stops.size();
+
+    TransportRouter unlimited(stopsDict, busesDict, WithEngine(RoutingEngine::Auto));
+    ExpectSameRoutes(network, expected, unlimited);
+    // Without a budget the cache is sized by the graph
+    EXPECT_GT(unlimited.GetRouteCacheStats().hits, 0u);
+    unlimited.SelectRoutingEngine(routeCount);
+    ExpectSameRoutes(network, expected, unlimited);
+
+    // No table fits, searches answer from the cache within the budget
+    RoutingSettings settings = WithEngine(RoutingEngine::Auto);
+    settings.routing_memory_bytes = 1 << 12;
+    TransportRouter limited(stopsDict, busesDict, settings);
+    limited.SelectRoutingEngine(routeCount);
+    ExpectSameRoutes(network, expected, limited);
+}
+
+TEST(TransportRouterTests, AutoEngineSelection)
+{
+    const size_t vertexCount = 2000;
+    const size_t edgeCount = 60'000;
+    const size_t tableBytes = vertexCount * vertexCount * 12;
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 10, 0, 12), RoutingEngine::Dijkstra);
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 1'000'000, 0, 12), RoutingEngine::FloydWarshall);
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 1'000'000, tableBytes, 12), RoutingEngine::FloydWarshall);
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 1'000'000, tableBytes - 1, 12),
+              RoutingEngine::ContractionHierarchy);
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 1'000'000, tableBytes - 1, 8), RoutingEngine::FloydWarshall);
+    EXPECT_EQ(SelectAutoRoutingEngine(vertexCount, edgeCount, 0, 0, 12), RoutingEngine::Dijkstra);
+}
+
+TEST(TransportRouterTests, DisconnectedDepotRoutesAreNotFound)
+{
+    auto network = MakeRandomNetwork(30, 6, 6, 25);
+    for (int i = 0; i < 3; ++i)
+    {
+        network.stops.push_back(Descriptions::Stop{
+            .name = "Depot " + std::to_string(i),
+            .position = {.latitude = 55.5, .longitude = 37.4 + 0.01 * i},
+            .distances = {{"Depot " + std::to_string((i + 1) % 3), 700}}});
+    }
+    network.buses.push_back(Descriptions::Bus{
+        .name = "Depot loop",
+        .stops = {"Depot 0", "Depot 1", "Depot 2", "Depot 0"},
+        .isRoundtrip = true});
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+
+    // RAPTOR routes over bus lines without the reachability index
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::Raptor));
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Dijkstra, RoutingEngine::ContractionHierarchy})
+    {
+        const TransportRouter actual(stopsDict, busesDict, WithEngine(engine));
+        ExpectSameRoutes(network, expected, actual);
+        EXPECT_FALSE(actual.FindRoute("Stop 0", "Depot 1").has_value());
+        EXPECT_FALSE(actual.FindRoute("Depot 1", "Stop 0").has_value());
+        EXPECT_TRUE(actual.FindRoute("Depot 1", "Depot 0").has_value());
+
+        RoutingSettings metric = DefaultSettings;
+        metric.bus_velocity = 20.0;
+        EXPECT_FALSE(actual.FindRoute("Depot 2", "Stop 3", metric).has_value());
+    }
+}
+
+TEST(TransportRouterTests, RaptorEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 4);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    const TransportRouter actual(stopsDict, busesDict, WithEngine(RoutingEngine::Raptor));
+    ExpectSameRoutes(network, expected, actual);
+}
+
+TEST(TransportRouterTests, RaptorReusesBuffersAcrossNetworks)
+{
+    // Round buffers are per thread, a bigger network searched in between must not leak into routes
+    const auto bigNetwork = MakeRandomNetwork(60, 10, 8, 5);
+    const auto network = MakeRandomNetwork(20, 5, 6, 6);
+    const TransportRouter bigRouter(MakeStopsDict(bigNetwork), MakeBusesDict(bigNetwork), WithEngine(RoutingEngine::Raptor));
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    const TransportRouter actual(stopsDict, busesDict, WithEngine(RoutingEngine::Raptor));
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            bigRouter.FindRoute(bigNetwork.stops.back().name, bigNetwork.stops.front().name);
+            const auto expectedRoute = expected.FindRoute(from.name, to.name);
+            const auto actualRoute = actual.FindRoute(from.name, to.name);
+            ASSERT_EQ(expectedRoute.has_value(), actualRoute.has_value()) << from.name << " -> " << to.name;
+            if (expectedRoute)
+            {
+                EXPECT_NEAR(expectedRoute->total_time, actualRoute->total_time, 1e-9);
+                EXPECT_NEAR(actualRoute->total_time, ComputeItemsTime(*actualRoute), 1e-9);
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, AStarEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 5);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, WithEngine(RoutingEngine::AStar)));
+
+    RoutingSettings lineSettings = WithEngine(RoutingEngine::AStar);
+    lineSettings.graph_model = GraphModel::LineExpanded;
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, lineSettings));
+}
+
+TEST(TransportRouterTests, AStarEngineWithRoadShorterThanGeoDistance)
+{
+    auto network = MakeRandomNetwork(40, 8, 7, 6);
+    for (auto &stop : network.stops)
+    {
+        for (auto &[_, distance] : stop.distances)
+        {
+            distance /= 10;
+        }
+        if (!stop.distances.empty())
+        {
+            break;
+        }
+    }
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, WithEngine(RoutingEngine::AStar)));
+}
+
+TEST(TransportRouterTests, AltEngineMatchesFloydWarshall)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 7);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::FloydWarshall));
+    for (const auto selection : {LandmarkSelection::Farthest, LandmarkSelection::Planar})
+    {
+        RoutingSettings settings = WithEngine(RoutingEngine::Alt);
+        settings.landmark_count = 4;
+        settings.landmark_selection = selection;
+        ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+        settings.graph_model = GraphModel::LineExpanded;
+        ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+    }
+}
+
+TEST(TransportRouterTests, LineExpandedModelMatchesStopPairs)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 3);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    RoutingSettings lineSettings = WithEngine(RoutingEngine::Dijkstra);
+    lineSettings.graph_model = GraphModel::LineExpanded;
+    const TransportRouter expected(stopsDict, busesDict, WithEngine(RoutingEngine::Dijkstra));
+    const TransportRouter actual(stopsDict, busesDict, lineSettings);
+    ExpectSameRoutes(network, expected, actual);
+
+    // Rides are collapsed back into whole bus items, so the total is exactly the sum of items
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            if (const auto route = actual.FindRoute(from.name, to.name))
+            {
+                EXPECT_EQ(route->total_time, ComputeItemsTime(*route));
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, StopOrdersGiveSameRoutes)
+{
+    const auto network = MakeRandomNetwork(40, 8, 7, 17);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    for (const auto order : {StopOrder::Bfs, StopOrder::ReverseCuthillMcKee, StopOrder::Hilbert})
+    {
+        for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Alt, RoutingEngine::Raptor})
+        {
+            RoutingSettings settings = WithEngine(engine);
+            settings.stop_order = order;
+            ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+            settings.graph_model = GraphModel::LineExpanded;
+            ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+        }
+    }
+}
+
+TEST(TransportRouterTests, RouteTimesMatchFindRoute)
+{
+    const auto network = MakeRandomNetwork(30, 6, 7, 9);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    std::vector<std::string> stops;
+    for (const auto &stop : network.stops)
+    {
+        stops.push_back(stop.name);
+    }
+    const std::vector<std::string> stopsFrom(stops.begin(), stops.begin() + 10);
+
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Dijkstra, RoutingEngine::ContractionHierarchy,
+                              RoutingEngine::Raptor, RoutingEngine::AStar, RoutingEngine::Alt,
+                              RoutingEngine::BidirectionalDijkstra, RoutingEngine::HubLabels})
+    {
+        const TransportRouter router(stopsDict, busesDict, WithEngine(engine));
+        const auto times = router.ComputeRouteTimes(stopsFrom, stops);
+        ASSERT_EQ(times.size(), stopsFrom.size());
+        for (size_t fromIdx = 0; fromIdx < stopsFrom.size(); ++fromIdx)
+        {
+            ASSERT_EQ(times[fromIdx].size(), stops.size());
+            for (size_t toIdx = 0; toIdx < stops.size(); ++toIdx)
+            {
+                const auto route = router.FindRoute(stopsFrom[fromIdx], stops[toIdx]);
+                ASSERT_EQ(route.has_value(), times[fromIdx][toIdx].has_value()) << stopsFrom[fromIdx] << " -> " << stops[toIdx];
+                if (route)
+                {
+                    EXPECT_NEAR(route->total_time, *times[fromIdx][toIdx], 1e-9);
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, RouteTimesOfUnknownStopsAreNotFound)
+{
+    const auto network = MakeRandomNetwork(30, 6, 7, 26);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    // Repeated targets check that one-to-many searches don't count a target twice
+    const std::vector<std::string> stopsFrom = {"Stop 0", "Nowhere", "Stop 1"};
+    const std::vector<std::string> stopsTo = {"Unknown", "Stop 2", "Stop 0", "Stop 2"};
+
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Dijkstra, RoutingEngine::Raptor,
+                              RoutingEngine::BidirectionalDijkstra})
+    {
+        const TransportRouter router(stopsDict, busesDict, WithEngine(engine));
+        const auto times = router.ComputeRouteTimes(stopsFrom, stopsTo);
+        ASSERT_EQ(times.size(), stopsFrom.size());
+        for (size_t fromIdx = 0; fromIdx < stopsFrom.size(); ++fromIdx)
+        {
+            ASSERT_EQ(times[fromIdx].size(), stopsTo.size());
+            for (size_t toIdx = 0; toIdx < stopsTo.size(); ++toIdx)
+            {
+                if (fromIdx == 1 || toIdx == 0)
+                {
+                    EXPECT_FALSE(times[fromIdx][toIdx].has_value()) << stopsFrom[fromIdx] << " -> " << stopsTo[toIdx];
+                    continue;
+                }
+                const auto route = router.FindRoute(stopsFrom[fromIdx], stopsTo[toIdx]);
+                ASSERT_EQ(route.has_value(), times[fromIdx][toIdx].has_value()) << stopsFrom[fromIdx] << " -> " << stopsTo[toIdx];
+                if (route)
+                {
+                    EXPECT_NEAR(route->total_time, *times[fromIdx][toIdx], 1e-9);
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, ReachableStopsMatchFindRoute)
+{
+    const auto network = MakeRandomNetwork(30, 6, 7, 10);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const double maxTime = 25.0;
+    for (const auto engine : {RoutingEngine::Dijkstra, RoutingEngine::Raptor})
+    {
+        for (const auto graphModel : {GraphModel::StopPairs, GraphModel::LineExpanded})
+        {
+            RoutingSettings settings = WithEngine(engine);
+            settings.graph_model = graphModel;
+            const TransportRouter router(stopsDict, busesDict, settings);
+            for (const auto &from : network.stops)
+            {
+                const auto reachableStops = router.FindReachableStops(from.name, maxTime);
+                std::map<std::string, double> reachableTimes;
+                for (const auto &stop : reachableStops)
+                {
+                    EXPECT_TRUE(reachableTimes.emplace(router.GetStopName(stop.stop_id), stop.time).second);
+                }
+                EXPECT_TRUE(std::is_sorted(reachableStops.begin(), reachableStops.end(), [](const auto &lhs, const auto &rhs)
+                                           { return lhs.time < rhs.time; }));
+
+                for (const auto &to : network.stops)
+                {
+                    const auto route = router.FindRoute(from.name, to.name);
+                    const auto it = reachableTimes.find(to.name);
+                    ASSERT_EQ(route && route->total_time <= maxTime, it != reachableTimes.end()) << from.name << " -> " << to.name;
+                    if (it != reachableTimes.end())
+                    {
+                        EXPECT_NEAR(route->total_time, it->second, 1e-9);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, MetricOverrideMatchesRouterBuiltWithIt)
+{
+    const auto network = MakeRandomNetwork(25, 6, 7, 11);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    RoutingSettings metric = DefaultSettings;
+    metric.bus_wait_time = 2;
+    metric.bus_velocity = 25.0;
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Raptor, RoutingEngine::Alt})
+    {
+        for (const auto graphModel : {GraphModel::StopPairs, GraphModel::LineExpanded})
+        {
+            RoutingSettings settings = WithEngine(engine);
+            settings.graph_model = graphModel;
+            RoutingSettings expectedSettings = metric;
+            expectedSettings.graph_model = graphModel;
+            const TransportRouter router(stopsDict, busesDict, settings);
+            const TransportRouter expectedRouter(stopsDict, busesDict, expectedSettings);
+            for (const auto &from : network.stops)
+            {
+                for (const auto &to : network.stops)
+                {
+                    const auto expected = expectedRouter.FindRoute(from.name, to.name);
+                    const auto actual = router.FindRoute(from.name, to.name, metric);
+                    ASSERT_EQ(expected.has_value(), actual.has_value()) << from.name << " -> " << to.name;
+                    if (!expected)
+                    {
+                        continue;
+                    }
+                    EXPECT_NEAR(expected->total_time, actual->total_time, 1e-9) << from.name << " -> " << to.name;
+                    EXPECT_NEAR(actual->total_time, ComputeItemsTime(*actual), 1e-9);
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, InvalidMetricOverrideIsRejected)
+{
+    const auto network = MakeRandomNetwork(25, 6, 7, 27);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter router(stopsDict, busesDict, WithEngine(RoutingEngine::Dijkstra));
+    for (const auto &[busWaitTime, busVelocity] : std::vector<std::pair<int, double>>{
+             {-1, 40.0}, {6, 0.0}, {6, -20.0}, {6, std::numeric_limits<double>::infinity()}})
+    {
+        RoutingSettings metric = DefaultSettings;
+        metric.bus_wait_time = busWaitTime;
+        metric.bus_velocity = busVelocity;
+        EXPECT_FALSE(metric.HasValidMetric()) << busWaitTime << ' ' << busVelocity;
+        EXPECT_FALSE(router.FindRoute("Stop 0", "Stop 0", metric).has_value()) << busWaitTime << ' ' << busVelocity;
+    }
+
+    auto context = std::make_shared<Requests::Context>(Requests::Context{
+        .transportDb = std::make_shared<TransportDatabase>(network, WithEngine(RoutingEngine::Dijkstra),
+                                                           Visualization::RenderSettings{}),
+        .yellowPagesDb = nullptr,
+        .mapVisualizer = nullptr});
+    const auto invalid = Requests::Route("Stop 0", "Stop 1", context, std::nullopt, 0.0).Process();
+    ASSERT_EQ(invalid.count("error_message"), 1u);
+    EXPECT_EQ(invalid.at("error_message").AsString(), "invalid routing settings");
+    EXPECT_EQ(Requests::Route("Stop 0", "Stop 1", context, -3).Process().count("error_message"), 1u);
+    EXPECT_EQ(Requests::Route("Stop 0", "Stop 0", context, 0, 20.0).Process().count("error_message"), 0u);
+}
+
+TEST(TransportRouterTests, ConcurrentRoutesMatchSequentialOnes)
+{
+    const auto network = MakeRandomNetwork(30, 6, 7, 13);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Dijkstra, RoutingEngine::ContractionHierarchy,
+                              RoutingEngine::BidirectionalDijkstra})
+    {
+        RoutingSettings settings = WithEngine(engine);
+        if (engine == RoutingEngine::Dijkstra)
+        {
+            settings.route_cache_bytes = 4096;  // a few trees, evicted while threads use them
+        }
+        const TransportRouter router(stopsDict, busesDict, settings);
+        std::vector<std::optional<double>> expected;
+        for (const auto &from : network.stops)
+        {
+            for (const auto &to : network.stops)
+            {
+                const auto route = router.FindRoute(from.name, to.name);
+                expected.push_back(route ? std::optional(route->total_time) : std::nullopt);
+            }
+        }
+
+        const size_t threadCount = 4;
+        std::vector<std::vector<std::optional<double>>> actual(threadCount);
+        std::vector<std::thread> threads;
+        for (size_t threadIdx = 0; threadIdx < threadCount; ++threadIdx)
+        {
+            threads.emplace_back([&, threadIdx]
+                                 {
+                for (const auto &from : network.stops)
+                {
+                    for (const auto &to : network.stops)
+                    {
+                        const auto route = router.FindRoute(from.name, to.name);
+                        actual[threadIdx].push_back(route ? std::optional(route->total_time) : std::nullopt);
+                    }
+                } });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        for (const auto &threadTimes : actual)
+        {
+            EXPECT_EQ(threadTimes, expected);
+        }
+    }
+}
+
+TEST(TransportRouterTests, ParallelBusEdgesArePrunedToEquivalentBuses)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 14);
+    auto twinNetwork = network;
+    auto twinBus = twinNetwork.buses.front();
+    twinBus.name = "Bus twin";
+    twinNetwork.buses.push_back(twinBus);
+    const auto stopsDict = MakeStopsDict(twinNetwork);
+    const TransportRouter expected(MakeStopsDict(network), MakeBusesDict(network), DefaultSettings);
+    const TransportRouter actual(stopsDict, MakeBusesDict(twinNetwork), DefaultSettings);
+    ExpectSameRoutes(twinNetwork, expected, actual);
+
+    size_t twinItemCount = 0;
+    for (const auto &from : twinNetwork.stops)
+    {
+        for (const auto &to : twinNetwork.stops)
+        {
+            const auto route = actual.FindRoute(from.name, to.name);
+            if (!route)
+            {
+                continue;
+            }
+            for (const auto &item : route->items)
+            {
+                const auto *busItem = std::get_if<TransportRouter::RouteInfo::BusItem>(&item);
+                if (!busItem)
+                {
+                    continue;
+                }
+                std::vector<std::string> busNames = {actual.GetBusName(busItem->bus_id)};
+                for (const uint32_t busId : busItem->equivalent_bus_ids)
+                {
+                    busNames.push_back(actual.GetBusName(busId));
+                }
+                const bool hasOriginal = std::count(busNames.begin(), busNames.end(), twinNetwork.buses.front().name) > 0;
+                const bool hasTwin = std::count(busNames.begin(), busNames.end(), twinBus.name) > 0;
+                EXPECT_EQ(hasOriginal, hasTwin) << from.name << " -> " << to.name;
+                twinItemCount += hasTwin;
+            }
+        }
+    }
+    EXPECT_GT(twinItemCount, 0u);
+}
+
+TEST(TransportRouterTests, BusesOfOneStopSequenceShareRides)
+{
+    const auto network = MakeRandomNetwork(30, 6, 6, 23);
+    auto twinNetwork = network;
+    for (const auto &bus : network.buses)
+    {
+        auto twinBus = bus;
+        twinBus.name = bus.name + " twin";
+        twinNetwork.buses.push_back(std::move(twinBus));
+    }
+    const TransportRouter expected(MakeStopsDict(network), MakeBusesDict(network), DefaultSettings);
+    const TransportRouter actual(MakeStopsDict(twinNetwork), MakeBusesDict(twinNetwork), DefaultSettings);
+    ExpectSameRoutes(twinNetwork, expected, actual);
+
+    for (const auto &from : network.stops)
+    {
+        for (const auto &to : network.stops)
+        {
+            const auto expectedRoute = expected.FindRoute(from.name, to.name);
+            const auto actualRoute = actual.FindRoute(from.name, to.name);
+            if (!expectedRoute)
+            {
+                continue;
+            }
+            ASSERT_EQ(expectedRoute->items.size(), actualRoute->items.size());
+            for (const auto &item : actualRoute->items)
+            {
+                const auto *busItem = std::get_if<TransportRouter::RouteInfo::BusItem>(&item);
+                if (!busItem)
+                {
+                    continue;
+                }
+                // Every bus riding the kept edge has its twin among the equivalent ones
+                std::vector<std::string> busNames = {actual.GetBusName(busItem->bus_id)};
+                for (const uint32_t busId : busItem->equivalent_bus_ids)
+                {
+                    busNames.push_back(actual.GetBusName(busId));
+                }
+                EXPECT_TRUE(std::is_sorted(busItem->equivalent_bus_ids.begin(), busItem->equivalent_bus_ids.end()));
+                EXPECT_EQ(busNames.size() % 2, 0u);
+                for (const auto &name : busNames)
+                {
+                    const bool isTwin = name.size() > 5 && name.compare(name.size() - 5, 5, " twin") == 0;
+                    const std::string twinName = isTwin ? name.substr(0, name.size() - 5) : name + " twin";
+                    EXPECT_EQ(std::count(busNames.begin(), busNames.end(), twinName), 1) << name;
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouterTests, GraphModelFromJson)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"graph_model", Json::Node(std::string("line_expanded"))}};
+    EXPECT_EQ(RoutingSettings::FromJson(json).graph_model, GraphModel::LineExpanded);
+}
+
+TEST(TransportRouterTests, StopOrderFromJson)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"stop_order", Json::Node(std::string("reverse_cuthill_mckee"))}};
+    EXPECT_EQ(RoutingSettings::FromJson(json).stop_order, StopOrder::ReverseCuthillMcKee);
+}
+
+TEST(TransportRouterTests, LandmarksFromJson)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"routing_engine", Json::Node(std::string("alt"))},
+        {"landmark_count", Json::Node(12)},
+        {"landmark_selection", Json::Node(std::string("planar"))}};
+    const auto settings = RoutingSettings::FromJson(json);
+    EXPECT_EQ(settings.routing_engine, RoutingEngine::Alt);
+    EXPECT_EQ(settings.landmark_count, 12);
+    EXPECT_EQ(settings.landmark_selection, LandmarkSelection::Planar);
+}
+
+TEST(TransportRouterTests, NegativeRoutingThreadsAreRejected)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"routing_threads", Json::Node(-1)}};
+    const auto settings = RoutingSettings::FromJson(json);
+    EXPECT_EQ(settings.routing_threads, 0);
+
+    // Settings made in code never get to the pool as a huge count either
+    RoutingSettings negative = DefaultSettings;
+    negative.routing_threads = -1;
+    EXPECT_EQ(negative.GetThreadCount(), 0u);
+    const auto network = MakeRandomNetwork(20, 4, 5, 31);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    for (const auto engine : {RoutingEngine::FloydWarshall, RoutingEngine::Dijkstra})
+    {
+        negative.routing_engine = engine;
+        ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, negative));
+    }
+}
+
+TEST(TransportRouterTests, InvalidLandmarkCountsAreRejected)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"landmark_count", Json::Node(-4)}};
+    EXPECT_EQ(RoutingSettings::FromJson(json).landmark_count, RoutingSettings{}.landmark_count);
+
+    const auto network = MakeRandomNetwork(20, 4, 5, 33);
+    const auto stopsDict = MakeStopsDict(network);
+    const auto busesDict = MakeBusesDict(network);
+    const TransportRouter expected(stopsDict, busesDict, DefaultSettings);
+    for (const int landmarkCount : {-1, 1'000'000'000})
+    {
+        for (const auto selection : {LandmarkSelection::Farthest, LandmarkSelection::Planar})
+        {
+            RoutingSettings settings = WithEngine(RoutingEngine::Alt);
+            settings.landmark_count = landmarkCount;
+            settings.landmark_selection = selection;
+            ExpectSameRoutes(network, expected, TransportRouter(stopsDict, busesDict, settings));
+        }
+    }
+}
+
+TEST(TransportRouterTests, RoutingEngineFromJson)
+{
+    const Json::Dict json = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"routing_engine", Json::Node(std::string("dijkstra"))}};
+    EXPECT_EQ(RoutingSettings::FromJson(json).routing_engine, RoutingEngine::Dijkstra);
+
+    const Json::Dict defaultJson = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)}};
+    EXPECT_EQ(RoutingSettings::FromJson(defaultJson).routing_engine, RoutingEngine::FloydWarshall);
+
+    const Json::Dict autoJson = {
+        {"bus_wait_time", Json::Node(2)},
+        {"bus_velocity", Json::Node(30)},
+        {"routing_engine", Json::Node(std::string("auto"))},
+        {"routing_memory_bytes", Json::Node(5e9)}};
+    const auto autoSettings = RoutingSettings::FromJson(autoJson);
+    EXPECT_EQ(autoSettings.routing_engine, RoutingEngine::Auto);
+    EXPECT_EQ(autoSettings.routing_memory_bytes, 5'000'000'000u);
+}